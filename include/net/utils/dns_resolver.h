@@ -0,0 +1,118 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OT_RTOS_DNS_RESOLVER_H_
+#define OT_RTOS_DNS_RESOLVER_H_
+
+#include <stdint.h>
+
+#include "lwip/err.h"
+#include "lwip/ip6.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * This function pointer is called when a host name has been resolved.
+ *
+ * It is called in the tcpip thread with the TCPIP core lock held.
+ *
+ * @param[in]  aHostName  The host name that was resolved.
+ * @param[in]  aAddress   The NAT64 address of the host, or NULL if it could not be resolved.
+ * @param[in]  aContext   The context passed to dnsResolve().
+ *
+ */
+typedef void (*dnsResolveCallback)(const char *aHostName, const ip6_addr_t *aAddress, void *aContext);
+
+/**
+ * This function resolves the IPv4 address of a host name to a NAT64 address, using the resolver cache.
+ *
+ * Answers are cached for their TTL, names that do not exist are cached briefly, and concurrent lookups of the
+ * same name share one query. Must be called from the tcpip thread or with the TCPIP core lock held.
+ *
+ * @param[in]   aHostName  The host name to resolve.
+ * @param[out]  aAddress   Where the address is written when it is answered from the cache.
+ * @param[in]   aCallback  The function called once the query completes, when ERR_INPROGRESS is returned.
+ * @param[in]   aContext   An arbitrary context passed to @p aCallback.
+ *
+ * @retval ERR_OK          The address was found in the cache and written to @p aAddress.
+ * @retval ERR_INPROGRESS  A query is in flight, @p aCallback will be called with the result.
+ * @retval ERR_VAL         The name is cached as not existing.
+ * @retval ERR_ARG         The host name is too long.
+ * @retval ERR_MEM         No cache entry or callback slot is available.
+ *
+ */
+err_t dnsResolve(const char *aHostName, ip6_addr_t *aAddress, dnsResolveCallback aCallback, void *aContext);
+
+/**
+ * This function pointer is called when all addresses of a host name have been resolved.
+ *
+ * It is called in the tcpip thread with the TCPIP core lock held.
+ *
+ * @param[in]  aHostName      The host name that was resolved.
+ * @param[in]  aAddresses     The NAT64 addresses of the host, in the order the server returned them.
+ * @param[in]  aNumAddresses  The number of addresses, 0 if the name could not be resolved.
+ * @param[in]  aContext       The context passed to dnsResolveAll().
+ *
+ */
+typedef void (*dnsResolveAllCallback)(const char *      aHostName,
+                                      const ip6_addr_t *aAddresses,
+                                      uint8_t           aNumAddresses,
+                                      void *            aContext);
+
+/**
+ * This function resolves all IPv4 addresses of a host name to NAT64 addresses, using the resolver cache.
+ *
+ * Behaves like dnsResolve(), up to `OTR_CONFIG_DNS_MAX_ADDRESSES` addresses are kept per name.
+ *
+ * @param[in]     aHostName      The host name to resolve.
+ * @param[out]    aAddresses     Where the addresses are written when they are answered from the cache.
+ * @param[inout]  aNumAddresses  On input the capacity of @p aAddresses, on output the number of addresses
+ *                               written when ERR_OK is returned.
+ * @param[in]     aCallback      The function called once the query completes, when ERR_INPROGRESS is returned.
+ * @param[in]     aContext       An arbitrary context passed to @p aCallback.
+ *
+ * @retval ERR_OK          The addresses were found in the cache.
+ * @retval ERR_INPROGRESS  A query is in flight, @p aCallback will be called with the result.
+ * @retval ERR_VAL         The name is cached as not existing.
+ * @retval ERR_ARG         The host name is too long.
+ * @retval ERR_MEM         No cache entry or callback slot is available.
+ *
+ */
+err_t dnsResolveAll(const char *          aHostName,
+                    ip6_addr_t *          aAddresses,
+                    uint8_t *             aNumAddresses,
+                    dnsResolveAllCallback aCallback,
+                    void *                aContext);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OT_RTOS_NAT64_CONNECT_H_
+#define OT_RTOS_NAT64_CONNECT_H_
+
+#include <stdint.h>
+
+#include "lwip/altcp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * This function pointer is called when nat64Connect() completes.
+ *
+ * It is called in the tcpip thread with the TCPIP core lock held. The connection has no callbacks or argument
+ * set, the receiver installs its own before returning.
+ *
+ * @param[in]  aPcb      The connected pcb, or NULL if no address of the host could be reached.
+ * @param[in]  aError    ERR_OK on success, otherwise the reason of the failure.
+ * @param[in]  aContext  The context passed to nat64Connect().
+ *
+ */
+typedef void (*nat64ConnectCallback)(struct altcp_pcb *aPcb, err_t aError, void *aContext);
+
+/**
+ * This function connects to a host through NAT64, trying all of its IPv4 addresses.
+ *
+ * Addresses that connected fastest before are tried first. Attempts are started
+ * `OTR_CONFIG_NAT64_CONNECT_DELAY` apart, or at once when the previous one fails. The first connection to be
+ * established is kept and the others are aborted. Must be called from the tcpip thread or with the TCPIP core
+ * lock held.
+ *
+ * @param[in]  aHostName   The host name to connect to.
+ * @param[in]  aPort       The TCP port to connect to.
+ * @param[in]  aAllocator  The allocator for the connection, e.g. for TLS, or NULL for plain TCP.
+ * @param[in]  aCallback   The function called once with the result, never before this function returns.
+ * @param[in]  aContext    An arbitrary context passed to @p aCallback.
+ *
+ * @retval ERR_OK   The connection is in progress, @p aCallback will be called.
+ * @retval ERR_MEM  Too many connections are in progress.
+ * @retval ERR_VAL  The host name does not exist.
+ * @retval ERR_CONN No connection attempt could be started.
+ *
+ */
+err_t nat64Connect(const char *         aHostName,
+                   uint16_t             aPort,
+                   altcp_allocator_t *  aAllocator,
+                   nat64ConnectCallback aCallback,
+                   void *               aContext);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -42,6 +42,18 @@ void setNat64Prefix(const ip6_addr_t *aNat64Prefix);
 ip6_addr_t getNat64Address(const ip4_addr_t *aIpv4Address);
 #endif
 
+/**
+ * This function resolves a host name to its NAT64 address, blocking the calling task until it is known.
+ *
+ * Answers come from the DNS resolver cache when possible, see dnsResolve() for the non-blocking variant.
+ * Must not be called from the tcpip thread.
+ *
+ * @param[in]   aHostName  The host name to resolve.
+ * @param[out]  aAddrOut   Where the address is written.
+ *
+ * @returns 0 on success, -1 if the name could not be resolved.
+ *
+ */
 int dnsNat64Address(const char *aHostName, ip6_addr_t *aAddrOut);
 
 #ifdef __cplusplus
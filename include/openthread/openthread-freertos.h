@@ -37,6 +37,7 @@
 
 #include <FreeRTOS.h>
 #include <portmacro.h>
+#include <task.h>
 #include <openthread/instance.h>
 
 #include "portable/portable.h"
@@ -52,17 +53,36 @@ extern "C" {
 void otrInit(int argc, char *argv[]);
 
 /**
- * This function starts OpenThread task.
+ * This function creates another OpenThread instance together with its lwIP netif.
+ *
+ * The instance initialized by otrInit() remains the default one. Must be called before otrStart(), at most
+ * `OTR_CONFIG_MAX_INSTANCES - 1` times.
+ *
+ * @returns A pointer to the new OpenThread instance.
+ *
+ */
+otInstance *otrAddInstance(void);
+
+/**
+ * This function starts one OpenThread task per instance.
  *
  */
 void otrStart(void);
 
 /**
- * This function notifies OpenThread task.
+ * This function notifies all OpenThread tasks.
  *
  */
 void otrTaskNotifyGive(void);
 
+/**
+ * This function notifies the OpenThread task of an instance.
+ *
+ * @param[in]  aInstance  A pointer to the OpenThread instance.
+ *
+ */
+void otrInstanceNotifyGive(otInstance *aInstance);
+
 /**
  * This function notifies OpenThread task from ISR.
  *
@@ -70,23 +90,124 @@ void otrTaskNotifyGive(void);
 void otrTaskNotifyGiveFromISR(void);
 
 /**
- * This function locks OpenThread task.
+ * This function blocks the calling task until one of the given task notification bits is set, and clears it.
+ *
+ * Notification bits of other users received meanwhile are posted again, so that their own waits still see them.
+ *
+ * @param[in]  aBits  The notification bits to wait for.
+ *
+ * @returns The bits of @p aBits that were set.
+ *
+ */
+uint32_t otrTaskNotifyWaitBits(uint32_t aBits);
+
+/**
+ * This function locks the OpenThread task of the default instance.
  *
  */
 void otrLock(void);
 
 /**
- * This function unlocks OpenThread task.
+ * This function unlocks the OpenThread task of the default instance.
  */
 void otrUnlock(void);
 
+/**
+ * This function locks the OpenThread task of an instance.
+ *
+ * @param[in]  aInstance  A pointer to the OpenThread instance.
+ *
+ */
+void otrInstanceLock(otInstance *aInstance);
+
+/**
+ * This function unlocks the OpenThread task of an instance.
+ *
+ * @param[in]  aInstance  A pointer to the OpenThread instance.
+ *
+ */
+void otrInstanceUnlock(otInstance *aInstance);
+
+/**
+ * The task notification bit set on the caller of otrCommandCall() when its command completes.
+ *
+ */
+#define OTR_COMMAND_NOTIFY_VALUE (1 << 13)
+
+/**
+ * This function pointer is called in the OpenThread task to run a command or report its completion.
+ *
+ * @param[in]  aInstance  A pointer to the OpenThread instance the command was posted to.
+ * @param[in]  aContext   The context of the command.
+ *
+ */
+typedef void (*otrCommandHandler)(otInstance *aInstance, void *aContext);
+
+/**
+ * This structure represents a command posted to the OpenThread task.
+ *
+ * The storage is owned by the caller and must stay valid until the command completes. Completion is reported by
+ * calling `mCompletion` and then notifying `mNotifyTask` with OTR_COMMAND_NOTIFY_VALUE, both optional. The
+ * OpenThread task does not touch the command after the last of the two.
+ *
+ */
+typedef struct otrCommand
+{
+    struct otrCommand *mNext;       ///< Used by the command queue.
+    otrCommandHandler  mHandler;    ///< Runs the command, may call any OpenThread api.
+    void *             mContext;    ///< Passed to `mHandler` and `mCompletion`.
+    otrCommandHandler  mCompletion; ///< Called after `mHandler`, may be NULL.
+    TaskHandle_t       mNotifyTask; ///< Notified after `mCompletion`, may be NULL.
+} otrCommand;
+
+/**
+ * This function posts a command to the OpenThread task of an instance without taking any lock.
+ *
+ * Commands run in the order they were posted, in the commands phase of the OpenThread main loop. Must not be
+ * called from ISR.
+ *
+ * @param[in]  aInstance  A pointer to the OpenThread instance.
+ * @param[in]  aCommand   A pointer to the command.
+ *
+ */
+void otrInstanceCommandPost(otInstance *aInstance, otrCommand *aCommand);
+
+/**
+ * This function runs a handler in the OpenThread task of an instance and waits for it to return.
+ *
+ * Called from the OpenThread task itself, the handler is run directly.
+ *
+ * @param[in]  aInstance  A pointer to the OpenThread instance.
+ * @param[in]  aHandler   The handler to run.
+ * @param[in]  aContext   The context passed to @p aHandler.
+ *
+ */
+void otrInstanceCommandCall(otInstance *aInstance, otrCommandHandler aHandler, void *aContext);
+
+/**
+ * This function posts a command to the OpenThread task of the default instance.
+ *
+ * @param[in]  aCommand   A pointer to the command.
+ *
+ */
+void otrCommandPost(otrCommand *aCommand);
+
+/**
+ * This function runs a handler in the OpenThread task of the default instance and waits for it to return.
+ *
+ * @param[in]  aHandler   The handler to run.
+ * @param[in]  aContext   The context passed to @p aHandler.
+ *
+ */
+void otrCommandCall(otrCommandHandler aHandler, void *aContext);
+
 /**
  * This function initializes user application.
  */
 void otrUserInit(void);
 
 /**
- * This function gets ot instance
+ * This function gets the default ot instance
  */
 otInstance *otrGetInstance();
 
@@ -132,6 +253,22 @@ portFORCE_INLINE static BaseType_t otrPortIsInsideInterrupt(void)
         otrTaskNotifyGive(); \
     } while (0)
 
+/**
+ * This macro provides a thread-safe way to call OpenThread api of a given instance in other threads
+ *
+ *  @param[in]  aInstance  pointer to the OpenThread instance the api is called on
+ *  @param[in]  ...        function call statement of OpenThread api
+ *
+ */
+#define OT_INSTANCE_API_CALL(aInstance, ...)  \
+    do                                        \
+    {                                         \
+        otrInstanceLock(aInstance);           \
+        __VA_ARGS__;                          \
+        otrInstanceUnlock(aInstance);         \
+        otrInstanceNotifyGive(aInstance);     \
+    } while (0)
+
 #ifdef __cplusplus
 }
 #endif
@@ -46,8 +46,26 @@
         __asm volatile("mrs %0, ipsr" : "=r"(x)::"memory"); \
     } while (0)
 
+extern uint32_t SystemCoreClock;
+
+// The DWT cycle counter stops while the core sleeps, it only measures active time.
+#define OTR_PORT_CYCLE_COUNTER_INIT()                   \
+    do                                                  \
+    {                                                   \
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; \
+        DWT->CYCCNT = 0;                                \
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;            \
+    } while (0)
+
+#define OTR_PORT_GET_CYCLES() (DWT->CYCCNT)
+
+#define OTR_PORT_CYCLES_PER_US (SystemCoreClock / 1000000)
+
 #else
 
+#include <stdint.h>
+#include <time.h>
+
 #define OTR_PORT_ENABLE_SLEEP() \
     do                          \
     {                           \
@@ -61,6 +79,33 @@
 
 #define UNUSED_VARIABLE(x) ((void)(x))
 
+#define OTR_PORT_CYCLE_COUNTER_INIT() \
+    do                                \
+    {                                 \
+    } while (0)
+
+#if OTR_CONFIG_VIRTUAL_TIME_ENABLE
+// The libc clock is simulated, the profiler keeps measuring real work.
+int __real_clock_gettime(clockid_t aClockId, struct timespec *aTime);
+#define OTR_PORT_CLOCK_GETTIME __real_clock_gettime
+#else
+#define OTR_PORT_CLOCK_GETTIME clock_gettime
+#endif
+
+// Microseconds, so that the 32 bit counter wraps after more than an hour.
+static inline uint32_t otrPortGetCycles(void)
+{
+    struct timespec now;
+
+    OTR_PORT_CLOCK_GETTIME(CLOCK_MONOTONIC, &now);
+
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000);
+}
+
+#define OTR_PORT_GET_CYCLES() otrPortGetCycles()
+
+#define OTR_PORT_CYCLES_PER_US 1
+
 #endif
 
 #endif
@@ -0,0 +1,161 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *   This file implements a pbuf alloc/free microbenchmark for the Linux build.
+ *
+ *   It times SYS_ARCH_PROTECT as the port implements it, the FreeRTOS mutex round trip it used to take, and a
+ *   pbuf_alloc()/pbuf_free() pair, each pair protecting the pool several times. Run as `pbuf_bench [iterations]`.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
+
+#include <lwip/pbuf.h>
+#include <lwip/sys.h>
+#include <lwip/tcpip.h>
+
+#define PBUF_BENCH_ITERATIONS 1000000
+#define PBUF_BENCH_SIZE 64
+
+static uint64_t getCpuTimeNs(void)
+{
+    struct timespec now;
+
+    // Thread CPU time, the simulated clock does not move while the loops run and other tasks are not counted.
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+static void printResult(const char *aName, uint64_t aStart, uint32_t aIterations)
+{
+    uint64_t elapsed = getCpuTimeNs() - aStart;
+
+    printf("%-18s %10lu ns %8.1f ns/op\r\n", aName, (unsigned long)elapsed, (double)elapsed / aIterations);
+}
+
+static void benchProtect(uint32_t aIterations)
+{
+    uint64_t start = getCpuTimeNs();
+
+    for (uint32_t i = 0; i < aIterations; i++)
+    {
+        sys_prot_t pval = sys_arch_protect();
+        sys_arch_unprotect(pval);
+    }
+
+    printResult("protect critical", start, aIterations);
+}
+
+static void benchMutex(uint32_t aIterations)
+{
+    SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+    uint64_t          start;
+
+    if (mutex == NULL)
+    {
+        printf("no mutex\r\n");
+        exit(EXIT_FAILURE);
+    }
+
+    start = getCpuTimeNs();
+
+    for (uint32_t i = 0; i < aIterations; i++)
+    {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        xSemaphoreGive(mutex);
+    }
+
+    printResult("protect mutex", start, aIterations);
+    vSemaphoreDelete(mutex);
+}
+
+static void benchPbuf(uint32_t aIterations)
+{
+    uint64_t start = getCpuTimeNs();
+
+    for (uint32_t i = 0; i < aIterations; i++)
+    {
+        struct pbuf *buffer = pbuf_alloc(PBUF_RAW, PBUF_BENCH_SIZE, PBUF_POOL);
+
+        if (buffer == NULL)
+        {
+            printf("pbuf pool exhausted\r\n");
+            exit(EXIT_FAILURE);
+        }
+
+        pbuf_free(buffer);
+    }
+
+    printResult("pbuf alloc free", start, aIterations);
+}
+
+static void benchTask(void *aContext)
+{
+    uint32_t iterations = *(uint32_t *)aContext;
+
+    // The pools are set up by lwip_init(), the tcpip thread sits idle while the loops run.
+    tcpip_init(NULL, NULL);
+
+    printf("%lu iterations\r\n", (unsigned long)iterations);
+    benchProtect(iterations);
+    benchMutex(iterations);
+    benchPbuf(iterations);
+
+    exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char *argv[])
+{
+    static uint32_t iterations = PBUF_BENCH_ITERATIONS;
+
+    if (argc > 1)
+    {
+        iterations = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+
+    if (iterations == 0)
+    {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Below the tcpip thread, as the application tasks allocating pbufs are.
+    xTaskCreate(benchTask, "bench", configMINIMAL_STACK_SIZE * 4, &iterations, 2, NULL);
+    vTaskStartScheduler();
+
+    return EXIT_FAILURE;
+}
@@ -32,6 +32,8 @@
 #include <openthread/openthread-freertos.h>
 #include <openthread/platform/uart.h>
 
+#include "otr_cli.h"
+
 #ifdef PLATFORM_linux
 #include <setjmp.h>
 #include <unistd.h>
@@ -51,6 +53,7 @@ int main(int argc, char *argv[])
 #endif
     otrInit(argc, argv);
     otCliUartInit(otrGetInstance());
+    otrCliInit();
     otrUserInit();
     otrStart();
     return 0;
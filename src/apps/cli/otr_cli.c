@@ -0,0 +1,407 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *   This file implements the OpenThread RTOS commands added to the OpenThread CLI.
+ */
+
+#include <string.h>
+
+#include <arch/altcp_tls_session.h>
+#include <arch/pbuf_class.h>
+#include <lwip/tcpip.h>
+#include <openthread/cli.h>
+#include <openthread/openthread-freertos.h>
+
+#include "netif.h"
+#include "otr_cli.h"
+#include "otr_config.h"
+#include "profiler.h"
+#include "scheduler.h"
+#include "virtual_time.h"
+#include "utils/heap.h"
+#include "utils/mbedtls_alloc.h"
+
+struct Command
+{
+    const char *mName;
+    otError (*mHandler)(uint8_t aArgsLength, char *aArgs[]);
+};
+
+#if OTR_CONFIG_NETIF_STATS_ENABLE
+static void printNetifStats(void)
+{
+    otrNetifStats stats;
+
+    netifGetStats(otrGetInstance(), &stats);
+
+    otCliOutputFormat("tx packets: %lu bytes: %lu\r\n", (unsigned long)stats.mTxPackets,
+                      (unsigned long)stats.mTxBytes);
+    otCliOutputFormat("tx enqueued: %lu dropped: %lu nobufs: %lu\r\n", (unsigned long)stats.mTxEnqueued,
+                      (unsigned long)stats.mTxDropped, (unsigned long)stats.mTxNoBufs);
+    otCliOutputFormat("tx paused: %lu pauses: %lu\r\n", (unsigned long)stats.mTxPaused,
+                      (unsigned long)stats.mTxPauses);
+    otCliOutputFormat("tx queue high water: %u burst max: %u wakeups: %lu\r\n", stats.mTxQueueHighWater,
+                      stats.mTxBurstMax, (unsigned long)stats.mTxWakeups);
+    otCliOutputFormat("rx packets: %lu bytes: %lu batches: %lu\r\n", (unsigned long)stats.mRxPackets,
+                      (unsigned long)stats.mRxBytes, (unsigned long)stats.mRxBatches);
+    otCliOutputFormat("rx dropped: %lu input errors: %lu\r\n", (unsigned long)stats.mRxDropped,
+                      (unsigned long)stats.mRxInputErrors);
+    otCliOutputFormat("copy failures: %lu\r\n", (unsigned long)stats.mCopyFailures);
+
+    otCliOutputFormat("tx latency (ms):\r\n");
+    otCliOutputFormat("  <1: %lu\r\n", (unsigned long)stats.mTxLatency[0]);
+
+    for (uint8_t i = 1; i < OTR_NETIF_LATENCY_BUCKETS - 1; i++)
+    {
+        otCliOutputFormat("  %lu-%lu: %lu\r\n", 1UL << (i - 1), (1UL << i) - 1, (unsigned long)stats.mTxLatency[i]);
+    }
+
+    otCliOutputFormat("  >=%lu: %lu\r\n", 1UL << (OTR_NETIF_LATENCY_BUCKETS - 2),
+                      (unsigned long)stats.mTxLatency[OTR_NETIF_LATENCY_BUCKETS - 1]);
+}
+
+static otError processNetif(uint8_t aArgsLength, char *aArgs[])
+{
+    otError error = OT_ERROR_NONE;
+
+    if (aArgsLength == 1 && strcmp(aArgs[0], "stats") == 0)
+    {
+        printNetifStats();
+    }
+    else if (aArgsLength == 2 && strcmp(aArgs[0], "stats") == 0 && strcmp(aArgs[1], "reset") == 0)
+    {
+        netifResetStats(otrGetInstance());
+    }
+    else
+    {
+        error = OT_ERROR_INVALID_ARGS;
+    }
+
+    return error;
+}
+#endif // OTR_CONFIG_NETIF_STATS_ENABLE
+
+#if OTR_CONFIG_PROFILER_ENABLE
+static void printProfile(void)
+{
+    otrProfilerStats stats;
+
+    profilerGetStats(otrGetInstance(), &stats);
+
+    for (uint8_t i = 0; i < OTR_PROFILER_NUM_PHASES; i++)
+    {
+        const otrProfilerPhaseStats *phase = &stats.mPhases[i];
+
+        otCliOutputFormat("%s: count: %lu total: %llu us max: %lu us\r\n", profilerPhaseName(i),
+                          (unsigned long)phase->mCount, (unsigned long long)phase->mTotalUs,
+                          (unsigned long)phase->mMaxUs);
+
+        // Only non-empty buckets, the full table of every phase does not fit a terminal.
+        for (uint8_t bucket = 0; bucket < OTR_PROFILER_BUCKETS; bucket++)
+        {
+            if (phase->mHistogram[bucket] == 0)
+            {
+                continue;
+            }
+
+            if (bucket == 0)
+            {
+                otCliOutputFormat("  <1: %lu\r\n", (unsigned long)phase->mHistogram[bucket]);
+            }
+            else if (bucket == OTR_PROFILER_BUCKETS - 1)
+            {
+                otCliOutputFormat("  >=%lu: %lu\r\n", 1UL << (bucket - 1), (unsigned long)phase->mHistogram[bucket]);
+            }
+            else
+            {
+                otCliOutputFormat("  %lu-%lu: %lu\r\n", 1UL << (bucket - 1), (1UL << bucket) - 1,
+                                  (unsigned long)phase->mHistogram[bucket]);
+            }
+        }
+    }
+}
+
+static otError processProfile(uint8_t aArgsLength, char *aArgs[])
+{
+    otError error = OT_ERROR_NONE;
+
+    if (aArgsLength == 0)
+    {
+        printProfile();
+    }
+    else if (aArgsLength == 1 && strcmp(aArgs[0], "reset") == 0)
+    {
+        profilerResetStats(otrGetInstance());
+    }
+    else
+    {
+        error = OT_ERROR_INVALID_ARGS;
+    }
+
+    return error;
+}
+#endif // OTR_CONFIG_PROFILER_ENABLE
+
+static void printHeapStats(void)
+{
+    for (uint8_t i = 0; i < OTR_HEAP_NUM_TAGS; i++)
+    {
+        otrHeapStats stats;
+
+        otrHeapGetStats((otrHeapTag)i, &stats);
+        otCliOutputFormat("%s: live: %lu peak: %lu allocs: %lu frees: %lu failures: %lu largest failure: %lu\r\n",
+                          otrHeapTagName((otrHeapTag)i), (unsigned long)stats.mLiveBytes,
+                          (unsigned long)stats.mPeakBytes, (unsigned long)stats.mAllocs, (unsigned long)stats.mFrees,
+                          (unsigned long)stats.mFailures, (unsigned long)stats.mLargestFailure);
+    }
+}
+
+static otError processHeap(uint8_t aArgsLength, char *aArgs[])
+{
+    otError error = OT_ERROR_NONE;
+
+    if (aArgsLength == 0)
+    {
+        printHeapStats();
+    }
+    else if (aArgsLength == 1 && strcmp(aArgs[0], "reset") == 0)
+    {
+        otrHeapResetStats();
+    }
+    else
+    {
+        error = OT_ERROR_INVALID_ARGS;
+    }
+
+    return error;
+}
+
+static void printPbufStats(void)
+{
+    struct pbuf_class_stats stats[PBUF_CLASS_NUM];
+
+    pbuf_class_get_stats(stats);
+
+    for (uint8_t i = 0; i < PBUF_CLASS_NUM; i++)
+    {
+        otCliOutputFormat("%s: size: %u buffers: %u in use: %u peak: %u allocs: %lu exhausted: %lu\r\n",
+                          stats[i].name, stats[i].size, stats[i].num, stats[i].used, stats[i].peak,
+                          (unsigned long)stats[i].allocs, (unsigned long)stats[i].exhausted);
+    }
+}
+
+static otError processPbuf(uint8_t aArgsLength, char *aArgs[])
+{
+    otError error = OT_ERROR_NONE;
+
+    if (aArgsLength == 0)
+    {
+        printPbufStats();
+    }
+    else if (aArgsLength == 1 && strcmp(aArgs[0], "reset") == 0)
+    {
+        pbuf_class_reset_stats();
+    }
+    else
+    {
+        error = OT_ERROR_INVALID_ARGS;
+    }
+
+    return error;
+}
+
+static void printSchedulerStats(void)
+{
+    otrSchedulerStats stats;
+
+    schedulerGetStats(otrGetInstance(), &stats);
+
+    otCliOutputFormat("preemptions: %lu\r\n", (unsigned long)stats.mPreemptions);
+
+    for (uint8_t i = 0; i < stats.mNumPhases; i++)
+    {
+        const otrSchedulerPhaseStats *phase = &stats.mPhases[i];
+
+        otCliOutputFormat("%s: priority: %u budget: %lu us runs: %lu misses: %lu max: %lu us\r\n", phase->mName,
+                          phase->mPriority, (unsigned long)phase->mBudgetUs, (unsigned long)phase->mRuns,
+                          (unsigned long)phase->mMisses, (unsigned long)phase->mMaxUs);
+    }
+}
+
+static otError processSched(uint8_t aArgsLength, char *aArgs[])
+{
+    otError error = OT_ERROR_NONE;
+
+    if (aArgsLength == 0)
+    {
+        printSchedulerStats();
+    }
+    else if (aArgsLength == 1 && strcmp(aArgs[0], "reset") == 0)
+    {
+        schedulerResetStats(otrGetInstance());
+    }
+    else
+    {
+        error = OT_ERROR_INVALID_ARGS;
+    }
+
+    return error;
+}
+
+#if PLATFORM_linux && OTR_CONFIG_VIRTUAL_TIME_ENABLE
+static otError processTime(uint8_t aArgsLength, char *aArgs[])
+{
+    otError             error = OT_ERROR_NONE;
+    otrVirtualTimeStats stats;
+
+    (void)aArgs;
+
+    if (aArgsLength == 0)
+    {
+        virtualTimeGetStats(&stats);
+        otCliOutputFormat("elapsed: %llu ms jumped: %llu ms jumps: %lu\r\n", (unsigned long long)stats.mElapsedMs,
+                          (unsigned long long)stats.mJumpedMs, (unsigned long)stats.mJumps);
+    }
+    else
+    {
+        error = OT_ERROR_INVALID_ARGS;
+    }
+
+    return error;
+}
+#endif
+
+static void printTlsStats(void)
+{
+    otrMbedtlsAllocStats           stats;
+    struct altcp_tls_session_stats sessionStats;
+
+    otrMbedtlsAllocGetStats(&stats);
+
+    otCliOutputFormat("handshakes: %lu last peak: %lu max peak: %lu\r\n", (unsigned long)stats.mHandshakes,
+                      (unsigned long)stats.mHandshakeLastPeak, (unsigned long)stats.mHandshakeMaxPeak);
+    otCliOutputFormat("sessions: %lu last peak: %lu max peak: %lu leaked blocks: %lu\r\n",
+                      (unsigned long)stats.mSessions, (unsigned long)stats.mSessionLastPeak,
+                      (unsigned long)stats.mSessionMaxPeak, (unsigned long)stats.mLeakedBlocks);
+    otCliOutputFormat("heap: %lu peak: %lu failures: %lu\r\n", (unsigned long)stats.mHeapInUse,
+                      (unsigned long)stats.mHeapPeak, (unsigned long)stats.mFailures);
+
+    LOCK_TCPIP_CORE();
+    altcp_tls_get_session_stats(&sessionStats);
+    UNLOCK_TCPIP_CORE();
+
+    otCliOutputFormat("client handshakes: full: %lu resumed: %lu rejected: %lu\r\n", (unsigned long)sessionStats.full,
+                      (unsigned long)sessionStats.resumed, (unsigned long)sessionStats.rejected);
+
+    for (uint8_t i = 0; i < OTR_MBEDTLS_POOL_NUM_CLASSES; i++)
+    {
+        const otrMbedtlsPoolStats *pool = &stats.mPools[i];
+
+        otCliOutputFormat("%u: blocks: %u in use: %u peak: %u exhausted: %lu\r\n", pool->mBlockSize,
+                          pool->mNumBlocks, pool->mInUse, pool->mPeak, (unsigned long)pool->mExhausted);
+    }
+}
+
+static otError processTls(uint8_t aArgsLength, char *aArgs[])
+{
+    otError error = OT_ERROR_NONE;
+
+    if (aArgsLength == 0)
+    {
+        printTlsStats();
+    }
+    else if (aArgsLength == 1 && strcmp(aArgs[0], "reset") == 0)
+    {
+        otrMbedtlsAllocResetStats();
+        LOCK_TCPIP_CORE();
+        altcp_tls_reset_session_stats();
+        UNLOCK_TCPIP_CORE();
+    }
+    else
+    {
+        error = OT_ERROR_INVALID_ARGS;
+    }
+
+    return error;
+}
+
+static const struct Command sCommands[] = {
+    {"heap", processHeap},
+#if OTR_CONFIG_NETIF_STATS_ENABLE
+    {"netif", processNetif},
+#endif
+    {"pbuf", processPbuf},
+#if OTR_CONFIG_PROFILER_ENABLE
+    {"profile", processProfile},
+#endif
+    {"sched", processSched},
+#if PLATFORM_linux && OTR_CONFIG_VIRTUAL_TIME_ENABLE
+    {"time", processTime},
+#endif
+    {"tls", processTls},
+    {NULL, NULL},
+};
+
+static void processOtr(uint8_t aArgsLength, char *aArgs[])
+{
+    otError error = OT_ERROR_INVALID_COMMAND;
+
+    if (aArgsLength == 0)
+    {
+        for (const struct Command *command = sCommands; command->mName != NULL; command++)
+        {
+            otCliOutputFormat("%s\r\n", command->mName);
+        }
+
+        error = OT_ERROR_NONE;
+    }
+    else
+    {
+        for (const struct Command *command = sCommands; command->mName != NULL; command++)
+        {
+            if (strcmp(aArgs[0], command->mName) == 0)
+            {
+                error = command->mHandler(aArgsLength - 1, aArgs + 1);
+                break;
+            }
+        }
+    }
+
+    otCliAppendResult(error);
+}
+
+static const otCliCommand sUserCommands[] = {
+    {"otr", processOtr},
+};
+
+void otrCliInit(void)
+{
+    otCliSetUserCommands(sUserCommands, sizeof(sUserCommands) / sizeof(sUserCommands[0]));
+}
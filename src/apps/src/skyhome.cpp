@@ -37,14 +37,15 @@
 #include <openthread/openthread-freertos.h>
 #include <openthread/thread.h>
 
-#include <lwip/altcp_tcp.h>
-#include <lwip/apps/http_client.h>
+#include <lwip/altcp.h>
 #include <lwip/netdb.h>
 #include <lwip/tcpip.h>
 
 #include <nrfx/hal/nrf_gpio.h>
 #include <nrfx/hal/nrf_gpiote.h>
 
+#include "thread_state.h"
+#include "net/utils/nat64_connect.h"
 #include "net/utils/nat64_utils.h"
 
 #ifndef DEMO_PASSPHRASE
@@ -55,6 +56,8 @@
 #define HTTP_BIT (1 << 2)
 #define BUTTON_BIT (1 << 3)
 
+#define HTTP_HOST "www.google.com"
+
 #define BUTTON1_PIN 11
 #define BUTTON2_PIN 12
 #define LED1_PIN 13
@@ -86,67 +89,82 @@ static void HandleJoinerCallback(otError aError, void *aContext)
 
 static void WaitForSignal(uint32_t aSignal)
 {
-    uint32_t notifyValue = 0;
-
-    do
-    {
-        xTaskNotifyWait(aSignal, aSignal, &notifyValue, portMAX_DELAY);
-    } while ((notifyValue & aSignal) == 0);
+    otrTaskNotifyWaitBits(aSignal);
 }
 
-static void HttpDoneCallback(void *aArg, httpc_result_t aResult, uint32_t aLen, uint32_t aStatusCode, err_t aErr)
+static const char sHttpRequest[] = "GET / HTTP/1.1\r\nHost: " HTTP_HOST "\r\nConnection: close\r\n\r\n";
+
+static err_t HttpRecvCallback(void *aArg, struct altcp_pcb *aConn, struct pbuf *aBuf, err_t aErr)
 {
     (void)aArg;
-    (void)aResult;
-    (void)aLen;
+    (void)aErr;
 
-    printf("Status code %d err %d\n", aStatusCode, aErr);
-    xTaskNotify(sDemoTask, HTTP_BIT, eSetBits);
+    if (aBuf == NULL)
+    {
+        // Closed by the server once the response is complete.
+        printf("Http done\n");
+        altcp_recv(aConn, NULL);
+        altcp_err(aConn, NULL);
+        if (altcp_close(aConn) != ERR_OK)
+        {
+            altcp_abort(aConn);
+            xTaskNotify(sDemoTask, HTTP_BIT, eSetBits);
+            return ERR_ABRT;
+        }
+        xTaskNotify(sDemoTask, HTTP_BIT, eSetBits);
+        return ERR_OK;
+    }
+
+    printf("Get data payload len %d\n", aBuf->tot_len);
+    altcp_recved(aConn, aBuf->tot_len);
+    pbuf_free(aBuf);
+
+    return ERR_OK;
 }
 
-static err_t HttpHeaderCallback(httpc_state_t *aConn,
-                                void *         aArg,
-                                struct pbuf *  aHdr,
-                                uint16_t       aLen,
-                                uint32_t       aContentLen)
+static void HttpErrCallback(void *aArg, err_t aErr)
 {
-    (void)aConn;
     (void)aArg;
-    (void)aHdr;
 
-    printf("Hdr len %d, content len %d\n", aLen, aContentLen);
+    printf("Http err %d\n", aErr);
+    xTaskNotify(sDemoTask, HTTP_BIT, eSetBits);
 }
 
-static err_t HttpRecvCallback(void *aArg, struct altcp_pcb *conn, struct pbuf *p, err_t err)
+static void HttpConnectedCallback(struct altcp_pcb *aConn, err_t aError, void *aContext)
 {
-    (void)conn;
-    (void)aArg;
-    if (err == ERR_OK)
+    (void)aContext;
+
+    if (aConn == NULL)
     {
-        printf("Get data payload len %d\n", p->tot_len);
+        printf("Connect failed err %d\n", aError);
+        xTaskNotify(sDemoTask, HTTP_BIT, eSetBits);
+        return;
     }
 
-    return ERR_OK;
+    altcp_recv(aConn, HttpRecvCallback);
+    altcp_err(aConn, HttpErrCallback);
+
+    if (altcp_write(aConn, sHttpRequest, sizeof(sHttpRequest) - 1, 0) != ERR_OK || altcp_output(aConn) != ERR_OK)
+    {
+        // The pcb cannot be aborted from here, so close it and keep the error callback only if that fails.
+        printf("Request failed\n");
+        altcp_err(aConn, NULL);
+        if (altcp_close(aConn) == ERR_OK)
+        {
+            xTaskNotify(sDemoTask, HTTP_BIT, eSetBits);
+        }
+        else
+        {
+            altcp_err(aConn, HttpErrCallback);
+        }
+    }
 }
 
 void demo101Task(void *p)
 {
-    ip_addr_t          serverAddr;
-    httpc_connection_t httpSettings;
-    altcp_allocator_t  allocator;
-
     sDemoTask = *static_cast<TaskHandle_t *>(p);
     WaitForSignal(BUTTON_BIT);
 
-    allocator.alloc = altcp_tcp_alloc;
-    allocator.arg   = NULL;
-
-    memset(&httpSettings, 0, sizeof(httpSettings));
-    httpSettings.use_proxy       = 0;
-    httpSettings.result_fn       = HttpDoneCallback;
-    httpSettings.headers_done_fn = HttpHeaderCallback;
-    httpSettings.altcp_allocator = &allocator;
-
     printf("Start join\n");
     // ifconfig up
     OT_API_CALL(otIp6SetEnabled(otrGetInstance(), true));
@@ -160,22 +178,29 @@ void demo101Task(void *p)
     printf("Enable thread\n");
     OT_API_CALL(otThreadSetEnabled(otrGetInstance(), true));
     setupNat64();
-    // wait a while for thread to connect
-    vTaskDelay(pdMS_TO_TICKS(2000));
-
-    // dns64 www.google.com
-    printf("Start curl www.google.com\n");
-    dnsNat64Address("www.google.com", &serverAddr.u_addr.ip6);
-    serverAddr.type = IPADDR_TYPE_V6;
+    // wait for thread to attach and get a global address
+    threadStateWait(otrGetInstance(), OTR_THREAD_STATE_ATTACHED | OTR_THREAD_STATE_GLOBAL_ADDRESS, portMAX_DELAY);
 
-    // periodically curl www.google.com
+    // periodically curl www.google.com, through whichever of its NAT64 addresses answers first
+    printf("Start curl " HTTP_HOST "\n");
     while (true)
     {
         uint32_t notifyValue;
+        err_t    err;
+
+        LOCK_TCPIP_CORE();
+        err = nat64Connect(HTTP_HOST, 80, NULL, HttpConnectedCallback, NULL);
+        UNLOCK_TCPIP_CORE();
+
+        if (err == ERR_OK)
+        {
+            WaitForSignal(HTTP_BIT);
+        }
+        else
+        {
+            printf("Connect failed err %d\n", err);
+        }
 
-        httpc_state_t *connection;
-        httpc_get_file(&serverAddr, 80, "/", &httpSettings, HttpRecvCallback, NULL, &connection);
-        WaitForSignal(HTTP_BIT);
         if (xTaskNotifyWait(BUTTON_BIT, BUTTON_BIT, &notifyValue, pdMS_TO_TICKS(10000)) == pdTRUE)
         {
             break;
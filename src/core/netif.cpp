@@ -31,11 +31,17 @@
  *   This file implements lwip net interface with OpenThread.
  */
 
+#include <FreeRTOS.h>
+#include <task.h>
+#include <timers.h>
+
+#include <arch/pbuf_class.h>
+#include <lwip/ip.h>
 #include <lwip/mld6.h>
 #include <lwip/netif.h>
+#include <lwip/priv/tcp_priv.h>
 #include <lwip/tcpip.h>
 #include <lwip/udp.h>
-#include <semphr.h>
 
 #include <openthread/icmp6.h>
 #include <openthread/ip6.h>
@@ -53,24 +59,114 @@
 #include "lwip/sockets.h"
 
 #include "netif.h"
+#include "otr_config.h"
+#include "utils/spsc_ring.hpp"
 
-static const size_t kMaxIp6Size = 1500;
+#if OTR_CONFIG_NETIF_STATS_ENABLE
+// Per-packet events are counted in sStats, keep formatted log lines off the hot path.
+#define netifLogPacket(aLogFunction, ...)
+#else
+#define netifLogPacket(aLogFunction, ...) aLogFunction(__VA_ARGS__)
+#endif
+
+struct OutputEntry
+{
+    struct pbuf *mBuffer;
+#if OTR_CONFIG_NETIF_STATS_ENABLE
+    uint32_t mTimestamp; ///< The time the packet was queued, in milliseconds.
+#endif
+};
 
 /**
- * This structure stores information needed to send a IPv6 packet.
+ * This structure holds the bridge state of one OpenThread instance and its lwIP netif.
  *
  */
-struct OutputEvent
+struct NetifContext
 {
-    OutputEvent *mNext;
-    uint16_t     mLength;
-    uint8_t      mData[1];
+    struct netif mNetif;
+    otInstance * mInstance;
+
+    // Packets are pushed with the TCPIP core lock held, so there is a single producer at any time.
+    ot::Rtos::SpscRing<OutputEntry, OTR_CONFIG_NETIF_TX_QUEUE_SIZE> mOutputQueue;
+    // Wakes the main loop to retry a packet deferred for lack of OpenThread message buffers.
+    TimerHandle_t mRetryTimer;
+#if configSUPPORT_STATIC_ALLOCATION
+    StaticTimer_t mRetryTimerBuffer;
+#endif
+#if OTR_CONFIG_NETIF_RX_BATCH_SIZE
+    // Received packets go from the OpenThread task to the tcpip thread.
+    ot::Rtos::SpscRing<struct pbuf *, OTR_CONFIG_NETIF_RX_BATCH_SIZE> mInputQueue;
+    bool                                                              mInputPending;
+#endif
+#if OTR_CONFIG_NETIF_FLOW_CONTROL_ENABLE
+    // Written by the OpenThread task only, read by lwIP before a packet is queued.
+    bool mCongested;
+#endif
+    otrNetifStats mStats;
+
+    // Multicast groups joined on behalf of OpenThread, lwIP keeps a use count per group.
+    otIp6Address mJoinedGroups[OTR_CONFIG_NETIF_MAX_MULTICAST_GROUPS];
+    int8_t       mNumJoinedGroups;
 };
 
-static SemaphoreHandle_t sGuardOutput = NULL;
-static OutputEvent *     sHeadOutput  = NULL;
-static OutputEvent *     sLastOutput  = NULL;
-static struct netif      sNetif;
+// Zero-initialized, contexts are handed out by netifInit() in the tcpip thread.
+static NetifContext sContexts[OTR_CONFIG_MAX_INSTANCES];
+static uint8_t      sNumContexts;
+
+// The statistics are written by the tcpip thread, the OpenThread task and the CLI, every access is a relaxed atomic.
+static void countStat(uint32_t &aCounter, uint32_t aValue = 1)
+{
+    __atomic_fetch_add(&aCounter, aValue, __ATOMIC_RELAXED);
+}
+
+static void raiseStat(uint16_t &aHighWater, uint16_t aValue)
+{
+    if (aValue > __atomic_load_n(&aHighWater, __ATOMIC_RELAXED))
+    {
+        __atomic_store_n(&aHighWater, aValue, __ATOMIC_RELAXED);
+    }
+}
+
+static NetifContext *getContext(otInstance *aInstance)
+{
+    NetifContext *context = NULL;
+
+    for (uint8_t i = 0; i < __atomic_load_n(&sNumContexts, __ATOMIC_ACQUIRE); i++)
+    {
+        if (sContexts[i].mInstance == aInstance)
+        {
+            context = &sContexts[i];
+            break;
+        }
+    }
+
+    return context;
+}
+
+#if OTR_CONFIG_NETIF_STATS_ENABLE
+static uint32_t getNowMs(void)
+{
+    return static_cast<uint32_t>(xTaskGetTickCount()) * portTICK_PERIOD_MS;
+}
+
+static void recordLatency(otrNetifStats &aStats, uint32_t aTimestamp)
+{
+    uint32_t elapsed = getNowMs() - aTimestamp;
+    uint8_t  bucket  = 0;
+
+    if (elapsed != 0)
+    {
+        bucket = static_cast<uint8_t>(32 - __builtin_clz(elapsed));
+
+        if (bucket >= OTR_NETIF_LATENCY_BUCKETS)
+        {
+            bucket = OTR_NETIF_LATENCY_BUCKETS - 1;
+        }
+    }
+
+    countStat(aStats.mTxLatency[bucket]);
+}
+#endif
 
 static bool IsLinkLocal(const struct otIp6Address &aAddress)
 {
@@ -84,42 +180,81 @@ static void HandleNetifStatus(struct netif *aNetif)
     otLogInfoPlat("LwIP netif event");
 }
 
+#if OTR_CONFIG_NETIF_TX_ZERO_COPY
+static bool chainNeedsCopy(const struct pbuf *aBuffer)
+{
+    bool needsCopy = false;
+
+    for (const struct pbuf *segment = aBuffer; segment != NULL && !needsCopy; segment = segment->next)
+    {
+        needsCopy = PBUF_NEEDS_COPY(segment);
+    }
+
+    return needsCopy;
+}
+#endif
+
 static err_t netifOutputIp6(struct netif *aNetif, struct pbuf *aBuffer, const ip6_addr_t *aPeerAddr)
 {
     (void)aPeerAddr;
 
-    err_t        err   = ERR_OK;
-    OutputEvent *event = NULL;
+    NetifContext &context = *static_cast<NetifContext *>(aNetif->state);
+    err_t         err     = ERR_OK;
+    OutputEntry   entry   = {};
+    uint16_t      length;
 
-    otLogInfoPlat("netif output");
-    assert(aNetif == &sNetif);
-    event = (OutputEvent *)malloc(sizeof(*event) + aBuffer->tot_len);
+    netifLogPacket(otLogInfoPlat, "netif output");
 
-    event->mLength = aBuffer->tot_len;
-    event->mNext   = NULL;
-    VerifyOrExit(event != NULL, err = ERR_BUF);
-    VerifyOrExit(aBuffer->tot_len == pbuf_copy_partial(aBuffer, event->mData, aBuffer->tot_len, 0), err = ERR_ARG);
+#if OTR_CONFIG_NETIF_FLOW_CONTROL_ENABLE
+    // A refused TCP segment stays on the unsent list, resumeOutput() kicks tcp_output() for it. lwIP arms the
+    // retransmission timer before the netif sees the segment, so the RTO can still fire during a long pause.
+    VerifyOrExit(!__atomic_load_n(&context.mCongested, __ATOMIC_ACQUIRE), err = ERR_WOULDBLOCK);
+#endif
 
-    xSemaphoreTake(sGuardOutput, portMAX_DELAY);
-    if (sLastOutput == NULL)
+#if OTR_CONFIG_NETIF_TX_ZERO_COPY
+    // The packet is consumed later by the OpenThread task, hold a reference until it has been appended to an
+    // OpenThread message. TCP does not rewrite a segment for retransmission while its pbuf is still referenced.
+    // PBUF_REF segments point at caller memory that is only valid during this call, those chains are copied.
+    if (!chainNeedsCopy(aBuffer))
     {
-        sHeadOutput = event;
-        sLastOutput = event;
+        pbuf_ref(aBuffer);
+        entry.mBuffer = aBuffer;
     }
     else
+#endif
     {
-        sLastOutput->mNext = event;
+        entry.mBuffer = pbuf_clone(PBUF_RAW, PBUF_RAM, aBuffer);
+        if (entry.mBuffer == NULL)
+        {
+            countStat(context.mStats.mCopyFailures);
+            ExitNow(err = ERR_MEM);
+        }
     }
-    xSemaphoreGive(sGuardOutput);
+#if OTR_CONFIG_NETIF_STATS_ENABLE
+    entry.mTimestamp = getNowMs();
+#endif
+
+    // Refuse rather than drop when full, so that TCP keeps the segment and backs off.
+    VerifyOrExit(context.mOutputQueue.Push(entry), err = ERR_MEM);
+
+    countStat(context.mStats.mTxEnqueued);
+    length = context.mOutputQueue.GetLength();
+    raiseStat(context.mStats.mTxQueueHighWater, length);
 
-    otrTaskNotifyGive();
+    otrInstanceNotifyGive(context.mInstance);
 
 exit:
-    if (err != ERR_OK)
+    if (err == ERR_WOULDBLOCK)
     {
-        if (event != NULL)
+        countStat(context.mStats.mTxPaused);
+    }
+    else if (err != ERR_OK)
+    {
+        countStat(context.mStats.mTxDropped);
+
+        if (entry.mBuffer != NULL)
         {
-            free(event);
+            pbuf_free(entry.mBuffer);
         }
     }
     return err;
@@ -146,274 +281,595 @@ static err_t netifInit(struct netif *aNetif)
 
 struct netif *otrGetNetif(void)
 {
-    return &sNetif;
+    return &sContexts[0].mNetif;
 }
 
-static void addMulticastAddress(const otIp6Address &aAddress)
+static ip6_addr_t toLwipAddress(const otIp6Address &aAddress)
 {
-    ip6_addr_t multicast_addr;
+    ip6_addr_t address;
+
+    memcpy(&address.addr, &aAddress, sizeof(aAddress));
+    address.zone = IP6_NO_ZONE;
 
-    memcpy(&multicast_addr.addr, &aAddress, sizeof(aAddress));
-    multicast_addr.zone = IP6_NO_ZONE;
-    mld6_joingroup_netif(&sNetif, &multicast_addr);
+    return address;
 }
 
-static void addAddress(const otIp6Address &aAddress)
+static bool hasUnicastAddress(otInstance *aInstance, const ip6_addr_t &aAddress)
 {
-    otError error = OT_ERROR_NONE;
-    err_t   err   = ERR_OK;
+    const otNetifAddress *address;
 
-    LOCK_TCPIP_CORE();
-
-    if (IsLinkLocal(aAddress))
+    for (address = otIp6GetUnicastAddresses(aInstance); address != NULL; address = address->mNext)
     {
-        netif_ip6_addr_set(&sNetif, 0, reinterpret_cast<const ip6_addr_t *>(&aAddress));
-        netif_ip6_addr_set_state(&sNetif, 0, IP6_ADDR_PREFERRED);
+        if (memcmp(&address->mAddress, aAddress.addr, sizeof(address->mAddress)) == 0)
+        {
+            break;
+        }
     }
-    else
-    {
-        int8_t                   index  = -1;
-        const otMeshLocalPrefix *prefix = otThreadGetMeshLocalPrefix(otrGetInstance());
 
-        err = netif_add_ip6_address(&sNetif, reinterpret_cast<const ip6_addr_t *>(&aAddress), &index);
-        VerifyOrExit(err == ERR_OK && index != -1, error = OT_ERROR_FAILED);
-        if (memcmp(&aAddress, prefix, sizeof(prefix->m8)) != 0)
+    return address != NULL;
+}
+
+static bool hasMulticastAddress(otInstance *aInstance, const otIp6Address &aAddress)
+{
+    const otNetifMulticastAddress *address;
+
+    for (address = otIp6GetMulticastAddresses(aInstance); address != NULL; address = address->mNext)
+    {
+        if (memcmp(&address->mAddress, &aAddress, sizeof(aAddress)) == 0)
         {
-            netif_ip6_addr_set_state(&sNetif, index, IP6_ADDR_PREFERRED);
+            break;
         }
-        else
+    }
+
+    return address != NULL;
+}
+
+static int8_t findJoinedGroup(const NetifContext &aContext, const otIp6Address &aAddress)
+{
+    int8_t index;
+
+    for (index = aContext.mNumJoinedGroups - 1; index >= 0; index--)
+    {
+        if (memcmp(&aContext.mJoinedGroups[index], &aAddress, sizeof(aAddress)) == 0)
         {
-            netif_ip6_addr_set_state(&sNetif, index, IP6_ADDR_VALID);
+            break;
         }
     }
 
-exit:
-    UNLOCK_TCPIP_CORE();
+    return index;
+}
 
-    if (error != OT_ERROR_NONE)
+static void syncNetifState(NetifContext &aContext)
+{
+    bool isUp = otIp6IsEnabled(aContext.mInstance);
+
+    VerifyOrExit(isUp != (netif_is_up(&aContext.mNetif) != 0));
+
+    if (isUp)
     {
-        otLogInfoPlat("Failed to add address: %d", error);
+        otLogInfoPlat("netif up");
+        netif_set_up(&aContext.mNetif);
     }
+    else
+    {
+        otLogInfoPlat("netif down");
+        netif_set_down(&aContext.mNetif);
+    }
+
+exit:
+    return;
 }
 
-static void delMulticastAddress(const otIp6Address &aAddress)
+static void syncUnicastAddresses(NetifContext &aContext)
 {
-    ip6_addr_t multicast_addr;
+    const otMeshLocalPrefix *prefix = otThreadGetMeshLocalPrefix(aContext.mInstance);
 
-    memcpy(&multicast_addr.addr, &aAddress, sizeof(aAddress));
-    multicast_addr.zone = IP6_NO_ZONE;
-    mld6_leavegroup_netif(&sNetif, &multicast_addr);
+    // Retire the lwIP slots whose address OpenThread no longer has.
+    for (int8_t i = 0; i < LWIP_IPV6_NUM_ADDRESSES; i++)
+    {
+        if (!ip6_addr_isinvalid(netif_ip6_addr_state(&aContext.mNetif, i)) &&
+            !hasUnicastAddress(aContext.mInstance, *netif_ip6_addr(&aContext.mNetif, i)))
+        {
+            netif_ip6_addr_set_state(&aContext.mNetif, i, IP6_ADDR_INVALID);
+        }
+    }
+
+    for (const otNetifAddress *address = otIp6GetUnicastAddresses(aContext.mInstance); address != NULL;
+         address                       = address->mNext)
+    {
+        ip6_addr_t lwipAddress = toLwipAddress(address->mAddress);
+        int8_t     index       = netif_get_ip6_addr_match(&aContext.mNetif, &lwipAddress);
+        u8_t       state;
+
+        if (index == -1)
+        {
+            if (IsLinkLocal(address->mAddress))
+            {
+                index = 0;
+                netif_ip6_addr_set(&aContext.mNetif, index, &lwipAddress);
+            }
+            else if (netif_add_ip6_address(&aContext.mNetif, &lwipAddress, &index) != ERR_OK || index == -1)
+            {
+                otLogWarnPlat("Failed to add address, no free netif slot");
+                continue;
+            }
+        }
+
+        // Mesh-local addresses stay valid but are not preferred, keeping them out of source address selection.
+        state = (memcmp(&address->mAddress, prefix, sizeof(prefix->m8)) == 0) ? IP6_ADDR_VALID : IP6_ADDR_PREFERRED;
+
+        if (netif_ip6_addr_state(&aContext.mNetif, index) != state)
+        {
+            netif_ip6_addr_set_state(&aContext.mNetif, index, state);
+        }
+    }
 }
 
-static void delAddress(const otIp6Address &aAddress)
+static void syncMulticastAddresses(NetifContext &aContext)
 {
-    int8_t index;
+    // Leave the groups OpenThread has unsubscribed from.
+    for (int8_t i = aContext.mNumJoinedGroups - 1; i >= 0; i--)
+    {
+        if (!hasMulticastAddress(aContext.mInstance, aContext.mJoinedGroups[i]))
+        {
+            ip6_addr_t group = toLwipAddress(aContext.mJoinedGroups[i]);
 
-    LOCK_TCPIP_CORE();
-    index = netif_get_ip6_addr_match(&sNetif, reinterpret_cast<const ip6_addr_t *>(&aAddress));
-    VerifyOrExit(index != -1);
-    netif_ip6_addr_set_state(&sNetif, index, IP6_ADDR_INVALID);
+            mld6_leavegroup_netif(&aContext.mNetif, &group);
+            aContext.mJoinedGroups[i] = aContext.mJoinedGroups[--aContext.mNumJoinedGroups];
+        }
+    }
 
-exit:
-    UNLOCK_TCPIP_CORE();
+    for (const otNetifMulticastAddress *address = otIp6GetMulticastAddresses(aContext.mInstance); address != NULL;
+         address                                = address->mNext)
+    {
+        ip6_addr_t group;
+
+        if (findJoinedGroup(aContext, address->mAddress) != -1)
+        {
+            continue;
+        }
+
+        if (aContext.mNumJoinedGroups == OTR_CONFIG_NETIF_MAX_MULTICAST_GROUPS)
+        {
+            otLogWarnPlat("Failed to join multicast group, too many groups");
+            break;
+        }
+
+        // A group lwIP cannot join now is retried on the next address change.
+        group = toLwipAddress(address->mAddress);
+        if (mld6_joingroup_netif(&aContext.mNetif, &group) == ERR_OK)
+        {
+            aContext.mJoinedGroups[aContext.mNumJoinedGroups++] = address->mAddress;
+        }
+    }
 }
 
-static void setupDns(void)
+static void setDnsServer(uint8_t aIndex, const char *aAddress)
 {
 #if LWIP_IPV4
     ip_addr_t dnsServer;
 
-    inet_pton(AF_INET6, "64:ff9b::808:808", &dnsServer.u_addr.ip6.addr);
+    VerifyOrExit(inet_pton(AF_INET6, aAddress, &dnsServer.u_addr.ip6.addr) == 1);
     dnsServer.type            = IPADDR_TYPE_V6;
     dnsServer.u_addr.ip6.zone = IP6_NO_ZONE;
 #else
     ip6_addr_t dnsServer;
 
-    inet_pton(AF_INET6, "64:ff9b::808:808", &dnsServer.addr);
+    VerifyOrExit(inet_pton(AF_INET6, aAddress, &dnsServer.addr) == 1);
     dnsServer.zone = IP6_NO_ZONE;
 #endif
 
+    dns_setserver(aIndex, &dnsServer);
+
+exit:
+    return;
+}
+
+static void setupDns(void)
+{
     dns_init();
-    dns_setserver(0, &dnsServer);
+    setDnsServer(0, OTR_CONFIG_DNS_SERVER);
+#if DNS_MAX_SERVERS > 1
+    setDnsServer(1, OTR_CONFIG_DNS_SERVER_SECONDARY);
+#endif
 }
 
 static void processStateChange(otChangedFlags aFlags, void *aContext)
 {
-    otInstance *instance = static_cast<otInstance *>(aContext);
+    const otChangedFlags kAddressFlags = OT_CHANGED_IP6_ADDRESS_ADDED | OT_CHANGED_IP6_ADDRESS_REMOVED |
+                                         OT_CHANGED_IP6_MULTICAST_SUBSCRIBED |
+                                         OT_CHANGED_IP6_MULTICAST_UNSUBSCRIBED | OT_CHANGED_THREAD_ML_ADDR;
+
+    NetifContext &context = *static_cast<NetifContext *>(aContext);
+
+    VerifyOrExit((aFlags & (OT_CHANGED_THREAD_NETIF_STATE | kAddressFlags)) != 0);
+
+    // Apply the whole change set under a single lock.
+    LOCK_TCPIP_CORE();
 
-    if (OT_CHANGED_THREAD_NETIF_STATE | aFlags)
+    if (aFlags & OT_CHANGED_THREAD_NETIF_STATE)
     {
-        LOCK_TCPIP_CORE();
-        if (otLinkIsEnabled(instance))
-        {
-            otLogInfoPlat("netif up");
-            netif_set_up(&sNetif);
-        }
-        else
-        {
-            otLogInfoPlat("netif down");
-            netif_set_down(&sNetif);
-        }
-        UNLOCK_TCPIP_CORE();
+        syncNetifState(context);
     }
+
+    if (aFlags & kAddressFlags)
+    {
+        syncUnicastAddresses(context);
+        syncMulticastAddresses(context);
+    }
+
+    UNLOCK_TCPIP_CORE();
+
+exit:
+    return;
 }
 
-static void processAddress(const otIp6Address *aAddress, uint8_t aPrefixLength, bool aIsAdded, void *aContext)
+#if OTR_CONFIG_NETIF_RX_BATCH_SIZE
+static void handleInputBatch(void *aContext)
 {
-    (void)aContext;
+    NetifContext &context = *static_cast<NetifContext *>(aContext);
+    struct pbuf **head;
 
-    // All multicast addresses have prefix ff00::/8
-    bool isMulticast = (aAddress->mFields.m8[0] == 0xff);
+    // Clear before draining, a packet queued after this point is covered by a new callback.
+    __atomic_store_n(&context.mInputPending, false, __ATOMIC_SEQ_CST);
 
-    otLogInfoPlat("address changed");
-
-    if (aIsAdded)
+    // Runs in the tcpip thread with the core lock held, feed the IP layer directly.
+    while ((head = context.mInputQueue.Peek()) != NULL)
     {
-        if (isMulticast)
-        {
-            addMulticastAddress(*aAddress);
-        }
-        else
+        struct pbuf *buffer = *head;
+
+        context.mInputQueue.Pop();
+
+        if (ip_input(buffer, &context.mNetif) != ERR_OK)
         {
-            addAddress(*aAddress);
+            countStat(context.mStats.mRxInputErrors);
+            pbuf_free(buffer);
         }
     }
+}
+
+static void flushReceive(NetifContext &aContext)
+{
+    VerifyOrExit(aContext.mInputQueue.Peek() != NULL);
+    VerifyOrExit(!__atomic_exchange_n(&aContext.mInputPending, true, __ATOMIC_SEQ_CST));
+
+    if (tcpip_try_callback(handleInputBatch, &aContext) == ERR_OK)
+    {
+        countStat(aContext.mStats.mRxBatches);
+    }
     else
     {
-        if (isMulticast)
-        {
-            delMulticastAddress(*aAddress);
-        }
-        else
-        {
-            delAddress(*aAddress);
-        }
+        // Message pool exhausted, try again on the next main loop pass.
+        __atomic_store_n(&aContext.mInputPending, false, __ATOMIC_SEQ_CST);
+        otrInstanceNotifyGive(aContext.mInstance);
     }
+
+exit:
+    return;
 }
+#endif // OTR_CONFIG_NETIF_RX_BATCH_SIZE
 
 static void processReceive(otMessage *aMessage, void *aContext)
 {
-    otError      error      = OT_ERROR_NONE;
-    err_t        err        = ERR_OK;
-    const size_t kBlockSize = 128;
-    uint16_t     length     = otMessageGetLength(aMessage);
-    struct pbuf *buffer     = NULL;
-    otInstance * aInstance  = static_cast<otInstance *>(aContext);
+    NetifContext &context = *static_cast<NetifContext *>(aContext);
+    otError       error   = OT_ERROR_NONE;
+    uint16_t      length  = otMessageGetLength(aMessage);
+    uint16_t      offset  = 0;
+    struct pbuf * buffer  = NULL;
+#if OTR_CONFIG_NETIF_RX_BATCH_SIZE
+    bool queued;
+#endif
 
-    assert(sNetif.state == aInstance);
+    // Inbound packets need no link header room. Take the best fitting size class and fall back to a pool chain when
+    // the classes are exhausted.
+    buffer = pbuf_class_alloc(length);
 
-    buffer = pbuf_alloc(PBUF_LINK, length, PBUF_POOL);
+    if (buffer == NULL)
+    {
+        buffer = pbuf_alloc(PBUF_RAW, length, PBUF_POOL);
+    }
 
     VerifyOrExit(buffer != NULL, error = OT_ERROR_NO_BUFS);
 
-    for (uint16_t i = 0; i < length; i += kBlockSize)
+    // Read the message straight into each segment of the pbuf chain.
+    for (struct pbuf *segment = buffer; segment != NULL; segment = segment->next)
     {
-        uint8_t block[kBlockSize];
-        int     count = otMessageRead(aMessage, i, block, sizeof(block));
+        int count = otMessageRead(aMessage, offset, segment->payload, segment->len);
 
-        assert(count > 0);
-        err = pbuf_take_at(buffer, block, count, i);
-        VerifyOrExit(err == ERR_OK, error = OT_ERROR_FAILED);
+        if (count != segment->len)
+        {
+            countStat(context.mStats.mCopyFailures);
+            ExitNow(error = OT_ERROR_PARSE);
+        }
+
+        offset += segment->len;
     }
 
-    VerifyOrExit(ERR_OK == sNetif.input(buffer, &sNetif), error = OT_ERROR_FAILED);
+#if OTR_CONFIG_NETIF_RX_BATCH_SIZE
+    // Handed to lwIP in one go by flushReceive() at the end of the main loop pass. A full batch is flushed early,
+    // while the tcpip thread has not drained it the packet takes the unbatched path behind the posted batch.
+    queued = context.mInputQueue.Push(buffer);
+
+    if (!queued)
+    {
+        flushReceive(context);
+        queued = context.mInputQueue.Push(buffer);
+    }
+
+    if (!queued)
+#endif
+    {
+        if (context.mNetif.input(buffer, &context.mNetif) != ERR_OK)
+        {
+            countStat(context.mStats.mRxInputErrors);
+            ExitNow(error = OT_ERROR_FAILED);
+        }
+    }
+    countStat(context.mStats.mRxPackets);
+    countStat(context.mStats.mRxBytes, length);
 
 exit:
     if (error != OT_ERROR_NONE)
     {
+        countStat(context.mStats.mRxDropped);
+
         if (buffer != NULL)
         {
             pbuf_free(buffer);
         }
 
-        if (error == OT_ERROR_FAILED)
-        {
-            otLogWarnPlat("%s failed for lwip error %d", __func__, err);
-        }
-
-        otLogWarnPlat("%s failed: %s", __func__, otThreadErrorToString(error));
+        netifLogPacket(otLogWarnPlat, "%s failed: %s", __func__, otThreadErrorToString(error));
     }
 
     otMessageFree(aMessage);
 }
 
-static void processTransmit(otInstance *aInstance)
+static otError transmitPacket(NetifContext &aContext, const OutputEntry &aEntry)
 {
     otError    error   = OT_ERROR_NONE;
-    otMessage *message = NULL;
-
-    VerifyOrExit(sHeadOutput != NULL);
+    otMessage *message = otIp6NewMessage(aContext.mInstance, NULL);
 
-    message = otIp6NewMessage(aInstance, NULL);
     VerifyOrExit(message != NULL, error = OT_ERROR_NO_BUFS);
 
-    SuccessOrExit(error = otMessageAppend(message, sHeadOutput->mData, sHeadOutput->mLength));
+    for (struct pbuf *segment = aEntry.mBuffer; segment != NULL; segment = segment->next)
+    {
+        SuccessOrExit(error = otMessageAppend(message, segment->payload, segment->len));
+    }
+
+#if OTR_CONFIG_NETIF_STATS_ENABLE
+    recordLatency(aContext.mStats, aEntry.mTimestamp);
+#endif
 
-    error   = otIp6Send(aInstance, message);
+    // The message is owned by OpenThread from here on, a send failure consumes the packet.
+    error   = otIp6Send(aContext.mInstance, message);
     message = NULL;
 
+    if (error != OT_ERROR_NONE)
     {
-        OutputEvent *nextEvent = sHeadOutput->mNext;
+        netifLogPacket(otLogWarnPlat, "Failed to send IPv6 packet: %s", otThreadErrorToString(error));
+        error = OT_ERROR_NONE;
+    }
 
-        free(sHeadOutput);
-        sHeadOutput = nextEvent;
+exit:
+    if (message != NULL)
+    {
+        otMessageFree(message);
     }
 
-    // Notify if more
-    if (sHeadOutput == NULL)
+    return error;
+}
+
+static void processTransmit(NetifContext &aContext)
+{
+    otError       error   = OT_ERROR_NONE;
+    uint16_t      packets = 0;
+    uint32_t      bytes   = 0;
+    OutputEntry * head;
+
+    while ((head = aContext.mOutputQueue.Peek()) != NULL)
     {
-        sLastOutput = NULL;
+        VerifyOrExit(packets < OTR_CONFIG_NETIF_TX_BURST_PACKETS);
+#if OTR_CONFIG_NETIF_TX_BURST_BYTES
+        VerifyOrExit(bytes < OTR_CONFIG_NETIF_TX_BURST_BYTES);
+#endif
+
+        // On failure the packet stays queued, the retry timer brings the main loop back to it.
+        SuccessOrExit(error = transmitPacket(aContext, *head));
+
+        bytes += head->mBuffer->tot_len;
+        pbuf_free(head->mBuffer);
+        aContext.mOutputQueue.Pop();
+        packets++;
     }
-    otrTaskNotifyGive();
 
 exit:
-    if (error != OT_ERROR_NONE)
+    if (packets > 0)
+    {
+        countStat(aContext.mStats.mTxWakeups);
+        countStat(aContext.mStats.mTxPackets, packets);
+        countStat(aContext.mStats.mTxBytes, bytes);
+        raiseStat(aContext.mStats.mTxBurstMax, packets);
+    }
+
+    if (error == OT_ERROR_NO_BUFS)
     {
-        if (message != NULL)
+        // OpenThread does not report when message buffers are released.
+        countStat(aContext.mStats.mTxNoBufs);
+        xTimerStart(aContext.mRetryTimer, 0);
+    }
+    else if (error != OT_ERROR_NONE)
+    {
+        otLogWarnPlat("Failed to transmit IPv6 packet: %s", otThreadErrorToString(error));
+    }
+    else if (head != NULL)
+    {
+        // Budget used up, come back after the other main loop work.
+        otrInstanceNotifyGive(aContext.mInstance);
+    }
+}
+
+static void retryTransmit(TimerHandle_t aTimer)
+{
+    NetifContext *context = static_cast<NetifContext *>(pvTimerGetTimerID(aTimer));
+
+    otrInstanceNotifyGive(context->mInstance);
+}
+
+#if OTR_CONFIG_NETIF_FLOW_CONTROL_ENABLE
+static void resumeOutput(void *aContext)
+{
+    (void)aContext;
+
+    // Runs in the tcpip thread, push out the segments refused while the netif was paused.
+    for (struct tcp_pcb *pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next)
+    {
+        if (pcb->unsent != NULL)
         {
-            otMessageFree(message);
+            tcp_output(pcb);
         }
+    }
+}
 
-        otLogWarnPlat("Failed to transmit IPv6 packet: %s", otThreadErrorToString(error));
+static void updateFlowControl(NetifContext &aContext)
+{
+    otBufferInfo bufferInfo;
+    bool         congested = __atomic_load_n(&aContext.mCongested, __ATOMIC_RELAXED);
+
+    otMessageGetBufferInfo(aContext.mInstance, &bufferInfo);
+
+    if (!congested && bufferInfo.mFreeBuffers < OTR_CONFIG_NETIF_FLOW_CONTROL_PAUSE_BUFFERS)
+    {
+        __atomic_store_n(&aContext.mCongested, true, __ATOMIC_RELEASE);
+        countStat(aContext.mStats.mTxPauses);
+    }
+    else if (congested && bufferInfo.mFreeBuffers >= OTR_CONFIG_NETIF_FLOW_CONTROL_RESUME_BUFFERS)
+    {
+        __atomic_store_n(&aContext.mCongested, false, __ATOMIC_RELEASE);
+
+        if (tcpip_try_callback(resumeOutput, NULL) != ERR_OK)
+        {
+            // Nothing would retry the refused segments, stay paused until the kick can be posted.
+            __atomic_store_n(&aContext.mCongested, true, __ATOMIC_RELEASE);
+            otrInstanceNotifyGive(aContext.mInstance);
+        }
     }
 }
+#endif // OTR_CONFIG_NETIF_FLOW_CONTROL_ENABLE
 
 void netifInit(void *aContext)
 {
     otInstance *instance = static_cast<otInstance *>(aContext);
 
-    memset(&sNetif, 0, sizeof(sNetif));
+    assert(sNumContexts < OTR_CONFIG_MAX_INSTANCES);
+
+    NetifContext &context = sContexts[sNumContexts];
+
+    memset(&context.mNetif, 0, sizeof(context.mNetif));
+    context.mInstance = instance;
+#if configSUPPORT_STATIC_ALLOCATION
+    context.mRetryTimer = xTimerCreateStatic("netif tx", pdMS_TO_TICKS(OTR_CONFIG_NETIF_TX_RETRY_INTERVAL), pdFALSE,
+                                             &context, retryTransmit, &context.mRetryTimerBuffer);
+#else
+    context.mRetryTimer =
+        xTimerCreate("netif tx", pdMS_TO_TICKS(OTR_CONFIG_NETIF_TX_RETRY_INTERVAL), pdFALSE, &context, retryTransmit);
+#endif
+    assert(context.mRetryTimer != NULL);
     // LOCK_TCPIP_CORE();
 #if LWIP_IPV4
-    netif_add(&sNetif, NULL, NULL, NULL, instance, netifInit, tcpip_input);
+    netif_add(&context.mNetif, NULL, NULL, NULL, &context, netifInit, tcpip_input);
 #else
-    netif_add(&sNetif, instance, netifInit, tcpip_input);
+    netif_add(&context.mNetif, &context, netifInit, tcpip_input);
 #endif
-    netif_set_link_up(&sNetif);
-    netif_set_status_callback(&sNetif, HandleNetifStatus);
+    netif_set_link_up(&context.mNetif);
+    netif_set_status_callback(&context.mNetif, HandleNetifStatus);
     // UNLOCK_TCPIP_CORE();
 
-    sGuardOutput = xSemaphoreCreateMutex();
-    xSemaphoreGive(sGuardOutput);
-    assert(sGuardOutput != NULL);
+    // Published once set up, the netif process functions ignore the instance until then.
+    __atomic_store_n(&sNumContexts, sNumContexts + 1, __ATOMIC_RELEASE);
+
     otLogInfoPlat("Initialize netif");
 
-    otIp6SetAddressCallback(instance, processAddress, instance);
-    otIp6SetReceiveCallback(instance, processReceive, instance);
-    otSetStateChangedCallback(instance, processStateChange, instance);
+    otIp6SetReceiveCallback(instance, processReceive, &context);
+    otSetStateChangedCallback(instance, processStateChange, &context);
     otIp6SetReceiveFilterEnabled(instance, true);
     otIcmp6SetEchoMode(instance, OT_ICMP6_ECHO_HANDLER_DISABLED);
 
-    netif_set_default(&sNetif);
+    // Called by tcpip_init() or tcpip_callback() with the core lock held, pick up the state OpenThread
+    // already has.
+    syncNetifState(context);
+    syncUnicastAddresses(context);
+    syncMulticastAddresses(context);
+
+    // The DNS client and the default route are shared, they belong to the first instance.
+    if (&context == &sContexts[0])
+    {
+        netif_set_default(&context.mNetif);
+        setupDns();
+    }
+}
+
+void netifProcessTransmit(otInstance *aInstance)
+{
+    NetifContext *context = getContext(aInstance);
+
+    VerifyOrExit(context != NULL);
+
+    processTransmit(*context);
+#if OTR_CONFIG_NETIF_FLOW_CONTROL_ENABLE
+    updateFlowControl(*context);
+#endif
+
+exit:
+    return;
+}
+
+void netifProcessReceive(otInstance *aInstance)
+{
+#if OTR_CONFIG_NETIF_RX_BATCH_SIZE
+    NetifContext *context = getContext(aInstance);
+
+    if (context != NULL)
+    {
+        flushReceive(*context);
+    }
+#else
+    (void)aInstance;
+#endif
+}
+
+void netifGetStats(otInstance *aInstance, otrNetifStats *aStats)
+{
+    NetifContext *context = getContext(aInstance);
+
+    static_assert(sizeof(otrNetifStats) % sizeof(uint32_t) == 0, "otrNetifStats must be made of 32-bit words");
 
-    setupDns();
+    if (context != NULL)
+    {
+        const uint32_t *source = reinterpret_cast<const uint32_t *>(&context->mStats);
+        uint32_t *      dest   = reinterpret_cast<uint32_t *>(aStats);
+
+        for (size_t i = 0; i < sizeof(otrNetifStats) / sizeof(uint32_t); i++)
+        {
+            dest[i] = __atomic_load_n(&source[i], __ATOMIC_RELAXED);
+        }
+    }
+    else
+    {
+        memset(aStats, 0, sizeof(*aStats));
+    }
 }
 
-void netifProcess(otInstance *aInstance)
+void netifResetStats(otInstance *aInstance)
 {
-    if (sGuardOutput != NULL && xSemaphoreTake(sGuardOutput, portMAX_DELAY) == pdTRUE)
+    NetifContext *context = getContext(aInstance);
+
+    if (context != NULL)
     {
-        processTransmit(aInstance);
-        xSemaphoreGive(sGuardOutput);
+        uint32_t *words = reinterpret_cast<uint32_t *>(&context->mStats);
+
+        for (size_t i = 0; i < sizeof(otrNetifStats) / sizeof(uint32_t); i++)
+        {
+            __atomic_store_n(&words[i], 0, __ATOMIC_RELAXED);
+        }
     }
 }
@@ -29,12 +29,85 @@
 #ifndef OTX_NETIF_H
 #define OTX_NETIF_H
 
+#include <stdint.h>
+
+#include <openthread/instance.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * The number of buckets in the transmit latency histogram.
+ *
+ */
+#define OTR_NETIF_LATENCY_BUCKETS 12
+
+/**
+ * This structure represents the statistics of the lwIP to OpenThread bridge.
+ *
+ */
+typedef struct otrNetifStats
+{
+    uint32_t mTxEnqueued;       ///< Packets queued by lwIP for transmission.
+    uint32_t mTxDropped;        ///< Packets refused because the transmit queue was full.
+    uint16_t mTxQueueHighWater; ///< The largest observed transmit queue length.
+    uint16_t mTxBurstMax;       ///< The largest number of packets sent in a single main loop pass.
+    uint32_t mTxWakeups;        ///< Main loop passes that sent at least one packet.
+    uint32_t mTxPackets;        ///< Packets handed to OpenThread, `mTxPackets / mTxWakeups` is the mean burst.
+    uint32_t mTxBytes;          ///< Bytes handed to OpenThread.
+    uint32_t mTxNoBufs;         ///< Transmit attempts deferred for lack of OpenThread message buffers, then retried.
+    uint32_t mRxPackets;        ///< Packets received from OpenThread and passed on to lwIP.
+    uint32_t mRxBytes;          ///< Bytes received from OpenThread and passed on to lwIP.
+    uint32_t mRxBatches;        ///< tcpip thread callbacks used to deliver `mRxPackets`.
+    uint32_t mRxDropped;        ///< Packets dropped for lack of pbufs.
+    uint32_t mRxInputErrors;    ///< Packets rejected by the lwIP IP layer.
+    uint32_t mCopyFailures;     ///< Packets lost while copying between pbufs and OpenThread messages.
+    uint32_t mTxPaused;         ///< Packets refused with `ERR_WOULDBLOCK` while OpenThread was congested.
+    uint32_t mTxPauses;         ///< Times lwIP output was paused for lack of OpenThread message buffers.
+
+    /**
+     * Time from `netifOutputIp6()` to `otIp6Send()`. Bucket 0 counts packets sent within the same millisecond,
+     * bucket n counts [2^(n-1), 2^n) ms and the last bucket everything above.
+     *
+     */
+    uint32_t mTxLatency[OTR_NETIF_LATENCY_BUCKETS];
+} otrNetifStats;
+
 void netifInit(void *aContext);
-void netifProcess(otInstance *aInstance);
+
+/**
+ * This function hands queued lwIP output of an instance to OpenThread, within the transmit burst budget.
+ *
+ * @param[in]  aInstance  A pointer to the OpenThread instance.
+ *
+ */
+void netifProcessTransmit(otInstance *aInstance);
+
+/**
+ * This function passes the batch of packets received by an instance on to the tcpip thread.
+ *
+ * @param[in]  aInstance  A pointer to the OpenThread instance.
+ *
+ */
+void netifProcessReceive(otInstance *aInstance);
+
+/**
+ * This function gets a snapshot of the netif statistics of an instance.
+ *
+ * @param[in]   aInstance  A pointer to the OpenThread instance.
+ * @param[out]  aStats     A pointer to where the statistics are copied.
+ *
+ */
+void netifGetStats(otInstance *aInstance, otrNetifStats *aStats);
+
+/**
+ * This function clears the netif statistics of an instance.
+ *
+ * @param[in]  aInstance  A pointer to the OpenThread instance.
+ *
+ */
+void netifResetStats(otInstance *aInstance);
 
 #ifdef __cplusplus
 }
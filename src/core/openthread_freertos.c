@@ -30,6 +30,8 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <FreeRTOS.h>
 #include <task.h>
@@ -43,43 +45,171 @@
 #include <openthread/diag.h>
 #include <openthread/tasklet.h>
 
+#include <jansson.h>
 #include <mbedtls/platform.h>
 
 #include "netif.h"
+#include "otr_config.h"
 #include "otr_system.h"
+#include "profiler.h"
+#include "scheduler.h"
+#include "thread_state.h"
 #include "uart_lock.h"
 #include "net/utils/nat64_utils.h"
 #include "portable/portable.h"
+#include "utils/heap.h"
+#include "utils/mbedtls_alloc.h"
 
-static TaskHandle_t      sMainTask     = NULL;
-static SemaphoreHandle_t sExternalLock = NULL;
-static otInstance *      sInstance     = NULL;
+#if OTR_CONFIG_MAX_INSTANCES > 1 && !OPENTHREAD_CONFIG_MULTIPLE_INSTANCE_ENABLE
+#error "OTR_CONFIG_MAX_INSTANCES > 1 requires OPENTHREAD_CONFIG_MULTIPLE_INSTANCE_ENABLE"
+#endif
+
+typedef struct InstanceContext
+{
+    otInstance *      mInstance;
+    TaskHandle_t      mMainTask;
+    SemaphoreHandle_t mExternalLock;
+    otrCommand *      mCommands;        // pushed by any task, taken as a whole by the main loop
+    otrCommand *      mPendingCommands; // taken but not run yet, in posting order
+    otrScheduler      mScheduler;
+#if OTR_CONFIG_PROFILER_ENABLE
+    otrProfilerStats mProfile; // only touched by the main loop task
+#endif
+#if configSUPPORT_STATIC_ALLOCATION
+    StaticSemaphore_t mExternalLockBuffer;
+    StaticTask_t      mMainTaskBuffer;
+    StackType_t       mMainTaskStack[OTR_CONFIG_MAIN_TASK_STACK_SIZE];
+#endif
+} InstanceContext;
+
+// The first instance is the default one used by otrGetInstance(), otrLock() and OT_API_CALL().
+static InstanceContext sContexts[OTR_CONFIG_MAX_INSTANCES];
+static uint8_t         sNumContexts = 0;
+
+static InstanceContext *getContext(otInstance *aInstance)
+{
+    InstanceContext *context = NULL;
+
+    for (uint8_t i = 0; i < sNumContexts; i++)
+    {
+        if (sContexts[i].mInstance == aInstance)
+        {
+            context = &sContexts[i];
+            break;
+        }
+    }
+
+    return context;
+}
+
+static void notifyContext(const InstanceContext *aContext)
+{
+#if !PLATFORM_linux || OTR_CONFIG_VIRTUAL_TIME_ENABLE
+    if (aContext->mMainTask != NULL)
+    {
+        xTaskNotifyGive(aContext->mMainTask);
+    }
+#else
+    // linux blocks in epoll rather than on the task notification
+    (void)aContext;
+    otrSystemWakeup();
+#endif
+}
 
-static void *mbedtlsCAlloc(size_t aCount, size_t aSize)
+static otInstance *newInstance(void)
 {
-    return calloc(aCount, aSize);
+    otInstance *instance;
+
+#if OPENTHREAD_CONFIG_MULTIPLE_INSTANCE_ENABLE
+    size_t size = 0;
+    void * buffer;
+
+    // The first call only reports the size of the instance.
+    otInstanceInit(NULL, &size);
+    buffer = otrHeapMalloc(OTR_HEAP_TAG_OT, size);
+    assert(buffer != NULL);
+    instance = otInstanceInit(buffer, &size);
+#else
+    instance = otInstanceInitSingle();
+#endif
+    assert(instance);
+
+    return instance;
 }
 
-static void mbedtlsFree(void *aPointer)
+static void processCommands(otInstance *aInstance)
 {
-    free(aPointer);
+    InstanceContext *context = getContext(aInstance);
+    uint8_t          budget  = OTR_CONFIG_SCHEDULER_COMMAND_BUDGET;
+
+    if (context->mPendingCommands == NULL)
+    {
+        otrCommand *list = __atomic_exchange_n(&context->mCommands, NULL, __ATOMIC_ACQUIRE);
+
+        // The queue is a stack, reverse it to run commands in posting order.
+        while (list != NULL)
+        {
+            otrCommand *next = list->mNext;
+
+            list->mNext               = context->mPendingCommands;
+            context->mPendingCommands = list;
+            list                      = next;
+        }
+    }
+
+    while (context->mPendingCommands != NULL && budget > 0)
+    {
+        otrCommand * command    = context->mPendingCommands;
+        TaskHandle_t notifyTask = command->mNotifyTask;
+
+        context->mPendingCommands = command->mNext;
+        budget--;
+        command->mHandler(aInstance, command->mContext);
+
+        if (command->mCompletion != NULL)
+        {
+            command->mCompletion(aInstance, command->mContext);
+        }
+
+        if (notifyTask != NULL)
+        {
+            xTaskNotify(notifyTask, OTR_COMMAND_NOTIFY_VALUE, eSetBits);
+        }
+    }
+
+    if (context->mPendingCommands != NULL)
+    {
+        // Budget used up, come back after the other main loop work.
+        notifyContext(context);
+    }
 }
 
+// The radio and platform drivers come first and are serviced again between the other phases.
+static const otrSchedulerPhase sPhases[] = {
+    {"system", otrSystemProcess, 0, OTR_CONFIG_SCHEDULER_SYSTEM_BUDGET_US, OTR_PROFILER_PHASE_PROCESS},
+    {"tasklets", otTaskletsProcess, OTR_CONFIG_SCHEDULER_TASKLETS_PRIORITY, OTR_CONFIG_SCHEDULER_TASKLETS_BUDGET_US,
+     OTR_PROFILER_PHASE_TASKLETS},
+    {"netif rx", netifProcessReceive, OTR_CONFIG_SCHEDULER_NETIF_RX_PRIORITY, OTR_CONFIG_SCHEDULER_NETIF_RX_BUDGET_US,
+     OTR_PROFILER_PHASE_NETIF_RX},
+    {"commands", processCommands, OTR_CONFIG_SCHEDULER_COMMANDS_PRIORITY, OTR_CONFIG_SCHEDULER_COMMANDS_BUDGET_US,
+     OTR_PROFILER_PHASE_COMMANDS},
+    {"netif tx", netifProcessTransmit, OTR_CONFIG_SCHEDULER_NETIF_TX_PRIORITY, OTR_CONFIG_SCHEDULER_NETIF_TX_BUDGET_US,
+     OTR_PROFILER_PHASE_NETIF_TX},
+};
+
 static void mainloop(void *aContext)
 {
-    int         i        = 0;
-    otInstance *instance = (otInstance *)aContext;
+    InstanceContext *context  = (InstanceContext *)aContext;
+    otInstance *     instance = context->mInstance;
 
-    otrSystemProcess(instance);
-    xSemaphoreTake(sExternalLock, portMAX_DELAY);
+    xSemaphoreTake(context->mExternalLock, portMAX_DELAY);
     while (!otSysPseudoResetWasRequested())
     {
-        otTaskletsProcess(instance);
-        xSemaphoreGive(sExternalLock);
-        otrSystemPoll(instance);
-        xSemaphoreTake(sExternalLock, portMAX_DELAY);
-        otrSystemProcess(instance);
-        netifProcess(instance);
+        schedulerRun(&context->mScheduler, instance);
+        xSemaphoreGive(context->mExternalLock);
+        OTR_PROFILE(&context->mProfile, OTR_PROFILER_PHASE_POLL, otrSystemPoll(instance));
+        OTR_PROFILE(&context->mProfile, OTR_PROFILER_PHASE_LOCK_WAIT,
+                    xSemaphoreTake(context->mExternalLock, portMAX_DELAY));
     }
 
     otInstanceFinalize(instance);
@@ -88,71 +218,257 @@ static void mainloop(void *aContext)
 
 void otrTaskNotifyGive()
 {
-#if !PLATFORM_linux // linux use select rather than event notification
-    xTaskNotifyGive(sMainTask);
-#endif
+    // Platform events are not tied to an instance, wake every main loop.
+    for (uint8_t i = 0; i < sNumContexts; i++)
+    {
+        notifyContext(&sContexts[i]);
+    }
+}
+
+uint32_t otrTaskNotifyWaitBits(uint32_t aBits)
+{
+    uint32_t value  = 0;
+    uint32_t others = 0;
+
+    while ((value & aBits) == 0)
+    {
+        xTaskNotifyWait(0, aBits, &value, portMAX_DELAY);
+        others |= value & ~aBits;
+    }
+
+    // Bits of other users woke this wait and consumed the pending state, re-arm it for their own wait.
+    if (others != 0)
+    {
+        xTaskNotify(xTaskGetCurrentTaskHandle(), others, eSetBits);
+    }
+
+    return value & aBits;
 }
 
 void otrTaskNotifyGiveFromISR()
 {
-#if !PLATFORM_linux // linux use select rather than event notification
+#if !PLATFORM_linux || OTR_CONFIG_VIRTUAL_TIME_ENABLE
     BaseType_t taskWoken;
 
-    vTaskNotifyGiveFromISR(sMainTask, &taskWoken);
+    for (uint8_t i = 0; i < sNumContexts; i++)
+    {
+        if (sContexts[i].mMainTask != NULL)
+        {
+            vTaskNotifyGiveFromISR(sContexts[i].mMainTask, &taskWoken);
+        }
+    }
+#else
+    otrSystemWakeup();
 #endif
 }
 
+void otrInstanceNotifyGive(otInstance *aInstance)
+{
+    InstanceContext *context = getContext(aInstance);
+
+    // OpenThread posts tasklets while otInstanceInit() runs, before the instance pointer is known.
+    if (context != NULL)
+    {
+        notifyContext(context);
+    }
+    else
+    {
+        otrTaskNotifyGive();
+    }
+}
+
 void otTaskletsSignalPending(otInstance *aInstance)
 {
-    (void)aInstance;
-    otrTaskNotifyGive();
-    // TODO aInstance != sInstance
-    // assert(aInstance == sInstance);
+    otrInstanceNotifyGive(aInstance);
 }
 
 void otrInit(int argc, char *argv[])
 {
-    mbedtls_platform_set_calloc_free(mbedtlsCAlloc, mbedtlsFree);
+    otrMbedtlsAllocInit();
+    mbedtls_platform_set_calloc_free(otrMbedtlsCAlloc, otrMbedtlsFree);
+    json_set_alloc_funcs(otrHeapJsonMalloc, otrHeapJsonFree);
 
     otrUartLockInit();
     otSysInit(argc, argv);
+    otrSystemInit();
+#if OTR_CONFIG_PROFILER_ENABLE
+    profilerInit();
+#endif
+
+    otrAddInstance();
+}
 
-    sInstance = otInstanceInitSingle();
-    assert(sInstance);
+otInstance *otrAddInstance(void)
+{
+    InstanceContext *context;
+
+    assert(sNumContexts < OTR_CONFIG_MAX_INSTANCES);
+    context = &sContexts[sNumContexts];
+
+#if configSUPPORT_STATIC_ALLOCATION
+    context->mExternalLock = xSemaphoreCreateMutexStatic(&context->mExternalLockBuffer);
+#else
+    context->mExternalLock = xSemaphoreCreateMutex();
+#endif
+    assert(context->mExternalLock != NULL);
+
+#if OTR_CONFIG_PROFILER_ENABLE
+    schedulerInit(&context->mScheduler, sPhases, sizeof(sPhases) / sizeof(sPhases[0]), &context->mProfile);
+#else
+    schedulerInit(&context->mScheduler, sPhases, sizeof(sPhases) / sizeof(sPhases[0]), NULL);
+#endif
+
+    // Register the slot before initializing the instance, its main task is woken once otrStart() creates it.
+    sNumContexts++;
+    context->mInstance = newInstance();
+    threadStateInit(context->mInstance);
 
 #if OPENTHREAD_ENABLE_DIAG
-    otDiagInit(sInstance);
+    otDiagInit(context->mInstance);
 #endif
-    tcpip_init(netifInit, sInstance);
 
-    sExternalLock = xSemaphoreCreateMutex();
-    assert(sExternalLock != NULL);
+    // Every instance gets its own lwIP netif, all of them served by the one tcpip thread.
+    if (context == &sContexts[0])
+    {
+        tcpip_init(netifInit, context->mInstance);
+    }
+    else
+    {
+        err_t err = tcpip_callback(netifInit, context->mInstance);
+
+        assert(err == ERR_OK);
+        (void)err;
+    }
+
+    return context->mInstance;
 }
 
+#if configSUPPORT_STATIC_ALLOCATION
+void vApplicationGetIdleTaskMemory(StaticTask_t **aTask, StackType_t **aStack, uint32_t *aStackSize)
+{
+    static StaticTask_t sIdleTask;
+    static StackType_t  sIdleTaskStack[configMINIMAL_STACK_SIZE];
+
+    *aTask      = &sIdleTask;
+    *aStack     = sIdleTaskStack;
+    *aStackSize = configMINIMAL_STACK_SIZE;
+}
+
+#if configUSE_TIMERS
+void vApplicationGetTimerTaskMemory(StaticTask_t **aTask, StackType_t **aStack, uint32_t *aStackSize)
+{
+    static StaticTask_t sTimerTask;
+    static StackType_t  sTimerTaskStack[configTIMER_TASK_STACK_DEPTH];
+
+    *aTask      = &sTimerTask;
+    *aStack     = sTimerTaskStack;
+    *aStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+#endif
+#endif // configSUPPORT_STATIC_ALLOCATION
+
 void otrStart(void)
 {
-    xTaskCreate(mainloop, "ot", 4096, sInstance, 2, &sMainTask);
+    for (uint8_t i = 0; i < sNumContexts; i++)
+    {
+#if configSUPPORT_STATIC_ALLOCATION
+        sContexts[i].mMainTask = xTaskCreateStatic(mainloop, "ot", OTR_CONFIG_MAIN_TASK_STACK_SIZE, &sContexts[i], 2,
+                                                   sContexts[i].mMainTaskStack, &sContexts[i].mMainTaskBuffer);
+#else
+        xTaskCreate(mainloop, "ot", OTR_CONFIG_MAIN_TASK_STACK_SIZE, &sContexts[i], 2, &sContexts[i].mMainTask);
+#endif
+    }
+
     // Activate deep sleep mode
     OTR_PORT_ENABLE_SLEEP();
     vTaskStartScheduler();
 }
 
-void otrLock(void)
+void otrInstanceLock(otInstance *aInstance)
 {
-    if (xTaskGetCurrentTaskHandle() != sMainTask)
+    InstanceContext *context = getContext(aInstance);
+
+    assert(context != NULL);
+
+    if (xTaskGetCurrentTaskHandle() != context->mMainTask)
+    {
+        xSemaphoreTake(context->mExternalLock, portMAX_DELAY);
+    }
+}
+
+void otrInstanceUnlock(otInstance *aInstance)
+{
+    InstanceContext *context = getContext(aInstance);
+
+    assert(context != NULL);
+
+    if (xTaskGetCurrentTaskHandle() != context->mMainTask)
     {
-        xSemaphoreTake(sExternalLock, portMAX_DELAY);
+        xSemaphoreGive(context->mExternalLock);
     }
 }
 
+void otrLock(void)
+{
+    otrInstanceLock(otrGetInstance());
+}
+
 void otrUnlock(void)
 {
-    if (xTaskGetCurrentTaskHandle() != sMainTask)
+    otrInstanceUnlock(otrGetInstance());
+}
+
+void otrInstanceCommandPost(otInstance *aInstance, otrCommand *aCommand)
+{
+    InstanceContext *context = getContext(aInstance);
+    otrCommand *     head;
+
+    assert(context != NULL && aCommand->mHandler != NULL);
+
+    head = __atomic_load_n(&context->mCommands, __ATOMIC_RELAXED);
+    do
     {
-        xSemaphoreGive(sExternalLock);
+        aCommand->mNext = head;
+    } while (!__atomic_compare_exchange_n(&context->mCommands, &head, aCommand, true, __ATOMIC_RELEASE,
+                                          __ATOMIC_RELAXED));
+
+    notifyContext(context);
+}
+
+void otrInstanceCommandCall(otInstance *aInstance, otrCommandHandler aHandler, void *aContext)
+{
+    InstanceContext *context = getContext(aInstance);
+
+    assert(context != NULL);
+
+    if (xTaskGetCurrentTaskHandle() == context->mMainTask)
+    {
+        aHandler(aInstance, aContext);
+    }
+    else
+    {
+        otrCommand command;
+
+        command.mHandler    = aHandler;
+        command.mContext    = aContext;
+        command.mCompletion = NULL;
+        command.mNotifyTask = xTaskGetCurrentTaskHandle();
+        otrInstanceCommandPost(aInstance, &command);
+
+        otrTaskNotifyWaitBits(OTR_COMMAND_NOTIFY_VALUE);
     }
 }
 
+void otrCommandPost(otrCommand *aCommand)
+{
+    otrInstanceCommandPost(otrGetInstance(), aCommand);
+}
+
+void otrCommandCall(otrCommandHandler aHandler, void *aContext)
+{
+    otrInstanceCommandCall(otrGetInstance(), aHandler, aContext);
+}
+
 void otSysEventSignalPending(void)
 {
     if (otrPortIsInsideInterrupt())
@@ -165,7 +481,50 @@ void otSysEventSignalPending(void)
     }
 }
 
+#if OTR_CONFIG_PROFILER_ENABLE
+void profilerGetStats(otInstance *aInstance, otrProfilerStats *aStats)
+{
+    InstanceContext *context = getContext(aInstance);
+
+    assert(context != NULL);
+    *aStats = context->mProfile;
+}
+
+void profilerResetStats(otInstance *aInstance)
+{
+    InstanceContext *context = getContext(aInstance);
+
+    assert(context != NULL);
+    memset(&context->mProfile, 0, sizeof(context->mProfile));
+}
+#endif
+
+void schedulerGetStats(otInstance *aInstance, otrSchedulerStats *aStats)
+{
+    InstanceContext *context = getContext(aInstance);
+
+    assert(context != NULL);
+    *aStats = context->mScheduler.mStats;
+}
+
+void schedulerResetStats(otInstance *aInstance)
+{
+    InstanceContext *  context = getContext(aInstance);
+    otrSchedulerStats *stats;
+
+    assert(context != NULL);
+    stats               = &context->mScheduler.mStats;
+    stats->mPreemptions = 0;
+
+    for (uint8_t i = 0; i < stats->mNumPhases; i++)
+    {
+        stats->mPhases[i].mRuns   = 0;
+        stats->mPhases[i].mMisses = 0;
+        stats->mPhases[i].mMaxUs  = 0;
+    }
+}
+
 otInstance *otrGetInstance()
 {
-    return sInstance;
+    return sContexts[0].mInstance;
 }
@@ -0,0 +1,473 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *   This file includes compile-time configuration defaults for OpenThread RTOS.
+ *
+ *   Any of the values below can be overridden on the compiler command line or in the project
+ *   configuration file named by `OTR_PROJECT_CONFIG_FILE`.
+ */
+
+#ifndef OTR_CONFIG_H_
+#define OTR_CONFIG_H_
+
+#ifdef OTR_PROJECT_CONFIG_FILE
+#include OTR_PROJECT_CONFIG_FILE
+#endif
+
+/**
+ * @def OTR_CONFIG_MAX_INSTANCES
+ *
+ * The number of OpenThread instances, each with its own main loop task and lwIP netif, that can run in one
+ * process. Values above 1 require `OPENTHREAD_CONFIG_MULTIPLE_INSTANCE_ENABLE`.
+ *
+ */
+#ifndef OTR_CONFIG_MAX_INSTANCES
+#define OTR_CONFIG_MAX_INSTANCES 1
+#endif
+
+/**
+ * @def OTR_CONFIG_NETIF_TX_ZERO_COPY
+ *
+ * Define to 1 to queue outgoing lwIP packets by reference and append their pbuf segments directly into the
+ * OpenThread message, or to 0 to take a private copy of each packet in the lwIP thread. Packets with volatile
+ * `PBUF_REF` segments are copied either way.
+ *
+ */
+#ifndef OTR_CONFIG_NETIF_TX_ZERO_COPY
+#define OTR_CONFIG_NETIF_TX_ZERO_COPY 1
+#endif
+
+/**
+ * @def OTR_CONFIG_NETIF_TX_QUEUE_SIZE
+ *
+ * The number of IPv6 packets that can be queued from lwIP to OpenThread. Must be a power of two. lwIP gets
+ * `ERR_MEM` back while the queue is full.
+ *
+ */
+#ifndef OTR_CONFIG_NETIF_TX_QUEUE_SIZE
+#define OTR_CONFIG_NETIF_TX_QUEUE_SIZE 16
+#endif
+
+/**
+ * @def OTR_CONFIG_NETIF_TX_BURST_PACKETS
+ *
+ * The maximum number of queued IPv6 packets handed to OpenThread in one main loop pass.
+ *
+ */
+#ifndef OTR_CONFIG_NETIF_TX_BURST_PACKETS
+#define OTR_CONFIG_NETIF_TX_BURST_PACKETS 8
+#endif
+
+/**
+ * @def OTR_CONFIG_NETIF_TX_BURST_BYTES
+ *
+ * The number of bytes after which a main loop pass stops handing queued IPv6 packets to OpenThread, or 0 to
+ * limit by packet count only.
+ *
+ */
+#ifndef OTR_CONFIG_NETIF_TX_BURST_BYTES
+#define OTR_CONFIG_NETIF_TX_BURST_BYTES 0
+#endif
+
+/**
+ * @def OTR_CONFIG_NETIF_TX_RETRY_INTERVAL
+ *
+ * The time in milliseconds after which a packet deferred because OpenThread was out of message buffers is retried.
+ *
+ */
+#ifndef OTR_CONFIG_NETIF_TX_RETRY_INTERVAL
+#define OTR_CONFIG_NETIF_TX_RETRY_INTERVAL 10
+#endif
+
+/**
+ * @def OTR_CONFIG_NETIF_RX_BATCH_SIZE
+ *
+ * The number of received IPv6 packets collected during a main loop pass and handed to the tcpip thread with a
+ * single callback. Must be a power of two, or 0 to post every packet to lwIP with `tcpip_input()`.
+ *
+ */
+#ifndef OTR_CONFIG_NETIF_RX_BATCH_SIZE
+#define OTR_CONFIG_NETIF_RX_BATCH_SIZE 16
+#endif
+
+/**
+ * @def OTR_CONFIG_NETIF_FLOW_CONTROL_ENABLE
+ *
+ * Define to 1 to pause lwIP output with `ERR_WOULDBLOCK` while OpenThread is running out of message buffers.
+ *
+ */
+#ifndef OTR_CONFIG_NETIF_FLOW_CONTROL_ENABLE
+#define OTR_CONFIG_NETIF_FLOW_CONTROL_ENABLE 1
+#endif
+
+/**
+ * @def OTR_CONFIG_NETIF_FLOW_CONTROL_PAUSE_BUFFERS
+ *
+ * lwIP output is paused when fewer OpenThread message buffers than this are free. The default leaves room for
+ * one full size IPv6 packet.
+ *
+ */
+#ifndef OTR_CONFIG_NETIF_FLOW_CONTROL_PAUSE_BUFFERS
+#define OTR_CONFIG_NETIF_FLOW_CONTROL_PAUSE_BUFFERS 12
+#endif
+
+/**
+ * @def OTR_CONFIG_NETIF_FLOW_CONTROL_RESUME_BUFFERS
+ *
+ * lwIP output is resumed once at least this many OpenThread message buffers are free again. Must be larger
+ * than `OTR_CONFIG_NETIF_FLOW_CONTROL_PAUSE_BUFFERS`.
+ *
+ */
+#ifndef OTR_CONFIG_NETIF_FLOW_CONTROL_RESUME_BUFFERS
+#define OTR_CONFIG_NETIF_FLOW_CONTROL_RESUME_BUFFERS 24
+#endif
+
+/**
+ * @def OTR_CONFIG_NETIF_MAX_MULTICAST_GROUPS
+ *
+ * The number of OpenThread multicast addresses mirrored as MLD groups on the lwIP netif.
+ *
+ */
+#ifndef OTR_CONFIG_NETIF_MAX_MULTICAST_GROUPS
+#define OTR_CONFIG_NETIF_MAX_MULTICAST_GROUPS 12
+#endif
+
+/**
+ * @def OTR_CONFIG_NETIF_STATS_ENABLE
+ *
+ * Define to 1 to time queued IPv6 packets and expose the netif statistics through the `otr netif stats` CLI
+ * command. Per-packet log lines in the netif are compiled out while this is enabled.
+ *
+ */
+#ifndef OTR_CONFIG_NETIF_STATS_ENABLE
+#define OTR_CONFIG_NETIF_STATS_ENABLE 1
+#endif
+
+/**
+ * @def OTR_CONFIG_DNS_SERVER
+ *
+ * The primary DNS server, reached through NAT64 by default.
+ *
+ */
+#ifndef OTR_CONFIG_DNS_SERVER
+#define OTR_CONFIG_DNS_SERVER "64:ff9b::808:808"
+#endif
+
+/**
+ * @def OTR_CONFIG_DNS_SERVER_SECONDARY
+ *
+ * The DNS server queried when the primary one does not answer, or an empty string for none.
+ *
+ */
+#ifndef OTR_CONFIG_DNS_SERVER_SECONDARY
+#define OTR_CONFIG_DNS_SERVER_SECONDARY "64:ff9b::808:404"
+#endif
+
+/**
+ * @def OTR_CONFIG_DNS_CACHE_SIZE
+ *
+ * The number of host names kept by the DNS resolver cache, including the ones being resolved.
+ *
+ */
+#ifndef OTR_CONFIG_DNS_CACHE_SIZE
+#define OTR_CONFIG_DNS_CACHE_SIZE 4
+#endif
+
+/**
+ * @def OTR_CONFIG_DNS_MAX_ADDRESSES
+ *
+ * The number of A records kept for each cached host name.
+ *
+ */
+#ifndef OTR_CONFIG_DNS_MAX_ADDRESSES
+#define OTR_CONFIG_DNS_MAX_ADDRESSES 4
+#endif
+
+/**
+ * @def OTR_CONFIG_DNS_MAX_NAME_LENGTH
+ *
+ * The longest host name the DNS resolver accepts.
+ *
+ */
+#ifndef OTR_CONFIG_DNS_MAX_NAME_LENGTH
+#define OTR_CONFIG_DNS_MAX_NAME_LENGTH 63
+#endif
+
+/**
+ * @def OTR_CONFIG_DNS_MAX_WAITERS
+ *
+ * The number of DNS resolver callbacks that can be outstanding at the same time.
+ *
+ */
+#ifndef OTR_CONFIG_DNS_MAX_WAITERS
+#define OTR_CONFIG_DNS_MAX_WAITERS 8
+#endif
+
+/**
+ * @def OTR_CONFIG_DNS_RETRY_INTERVAL
+ *
+ * The time in milliseconds after which an unanswered DNS query is sent again.
+ *
+ */
+#ifndef OTR_CONFIG_DNS_RETRY_INTERVAL
+#define OTR_CONFIG_DNS_RETRY_INTERVAL 2000
+#endif
+
+/**
+ * @def OTR_CONFIG_DNS_MAX_RETRIES
+ *
+ * The number of times a DNS query is sent to each server before giving up on it.
+ *
+ */
+#ifndef OTR_CONFIG_DNS_MAX_RETRIES
+#define OTR_CONFIG_DNS_MAX_RETRIES 3
+#endif
+
+/**
+ * @def OTR_CONFIG_DNS_MAX_TTL
+ *
+ * The upper bound in seconds applied to the TTL of cached DNS answers.
+ *
+ */
+#ifndef OTR_CONFIG_DNS_MAX_TTL
+#define OTR_CONFIG_DNS_MAX_TTL 3600
+#endif
+
+/**
+ * @def OTR_CONFIG_DNS_NEGATIVE_TTL
+ *
+ * The time in seconds a name that does not exist, or has no A record, is remembered.
+ *
+ */
+#ifndef OTR_CONFIG_DNS_NEGATIVE_TTL
+#define OTR_CONFIG_DNS_NEGATIVE_TTL 10
+#endif
+
+/**
+ * @def OTR_CONFIG_DNS_PREFETCH_ENABLE
+ *
+ * Define to 1 to refresh a cached DNS answer in the background when it is used during the last eighth of
+ * its TTL, so that it does not expire under a regular user.
+ *
+ */
+#ifndef OTR_CONFIG_DNS_PREFETCH_ENABLE
+#define OTR_CONFIG_DNS_PREFETCH_ENABLE 1
+#endif
+
+/**
+ * @def OTR_CONFIG_NAT64_CONNECT_DELAY
+ *
+ * The time in milliseconds nat64Connect() waits for a connection attempt before starting one to the next
+ * address of the host.
+ *
+ */
+#ifndef OTR_CONFIG_NAT64_CONNECT_DELAY
+#define OTR_CONFIG_NAT64_CONNECT_DELAY 300
+#endif
+
+/**
+ * @def OTR_CONFIG_NAT64_MAX_CONNECTIONS
+ *
+ * The number of nat64Connect() operations that can be in progress at the same time.
+ *
+ */
+#ifndef OTR_CONFIG_NAT64_MAX_CONNECTIONS
+#define OTR_CONFIG_NAT64_MAX_CONNECTIONS 2
+#endif
+
+/**
+ * @def OTR_CONFIG_NAT64_RTT_TABLE_SIZE
+ *
+ * The number of addresses whose connect round trip time is remembered to order later attempts.
+ *
+ */
+#ifndef OTR_CONFIG_NAT64_RTT_TABLE_SIZE
+#define OTR_CONFIG_NAT64_RTT_TABLE_SIZE 8
+#endif
+
+/**
+ * @def OTR_CONFIG_SCHEDULER_SYSTEM_INTERVAL
+ *
+ * The longest time in microseconds the main loop runs other work before the radio and platform drivers are
+ * serviced again. Checked between phases, a phase itself is never interrupted.
+ *
+ */
+#ifndef OTR_CONFIG_SCHEDULER_SYSTEM_INTERVAL
+#define OTR_CONFIG_SCHEDULER_SYSTEM_INTERVAL 1000
+#endif
+
+/**
+ * @def OTR_CONFIG_SCHEDULER_COMMAND_BUDGET
+ *
+ * The maximum number of posted commands run in a single main loop pass.
+ *
+ */
+#ifndef OTR_CONFIG_SCHEDULER_COMMAND_BUDGET
+#define OTR_CONFIG_SCHEDULER_COMMAND_BUDGET 8
+#endif
+
+/**
+ * @def OTR_CONFIG_SCHEDULER_*_PRIORITY
+ *
+ * The order of the main loop phases after the radio and platform drivers, lower values run first.
+ *
+ */
+#ifndef OTR_CONFIG_SCHEDULER_TASKLETS_PRIORITY
+#define OTR_CONFIG_SCHEDULER_TASKLETS_PRIORITY 1
+#endif
+
+#ifndef OTR_CONFIG_SCHEDULER_NETIF_RX_PRIORITY
+#define OTR_CONFIG_SCHEDULER_NETIF_RX_PRIORITY 2
+#endif
+
+#ifndef OTR_CONFIG_SCHEDULER_COMMANDS_PRIORITY
+#define OTR_CONFIG_SCHEDULER_COMMANDS_PRIORITY 3
+#endif
+
+#ifndef OTR_CONFIG_SCHEDULER_NETIF_TX_PRIORITY
+#define OTR_CONFIG_SCHEDULER_NETIF_TX_PRIORITY 4
+#endif
+
+/**
+ * @def OTR_CONFIG_SCHEDULER_*_BUDGET_US
+ *
+ * The time in microseconds a main loop phase may take per pass, longer runs are counted as deadline misses.
+ *
+ */
+#ifndef OTR_CONFIG_SCHEDULER_SYSTEM_BUDGET_US
+#define OTR_CONFIG_SCHEDULER_SYSTEM_BUDGET_US 500
+#endif
+
+#ifndef OTR_CONFIG_SCHEDULER_TASKLETS_BUDGET_US
+#define OTR_CONFIG_SCHEDULER_TASKLETS_BUDGET_US 2000
+#endif
+
+#ifndef OTR_CONFIG_SCHEDULER_NETIF_RX_BUDGET_US
+#define OTR_CONFIG_SCHEDULER_NETIF_RX_BUDGET_US 200
+#endif
+
+#ifndef OTR_CONFIG_SCHEDULER_COMMANDS_BUDGET_US
+#define OTR_CONFIG_SCHEDULER_COMMANDS_BUDGET_US 1000
+#endif
+
+#ifndef OTR_CONFIG_SCHEDULER_NETIF_TX_BUDGET_US
+#define OTR_CONFIG_SCHEDULER_NETIF_TX_BUDGET_US 1000
+#endif
+
+/**
+ * @def OTR_CONFIG_PROFILER_ENABLE
+ *
+ * Define to 1 to time every phase of the OpenThread main loop and expose the histograms through the
+ * `otr profile` CLI command.
+ *
+ */
+#ifndef OTR_CONFIG_PROFILER_ENABLE
+#define OTR_CONFIG_PROFILER_ENABLE 0
+#endif
+
+/**
+ * @def OTR_CONFIG_VIRTUAL_TIME_ENABLE
+ *
+ * Define to 1 to run the Linux build on a simulated clock that skips ahead whenever all tasks are blocked. Set by
+ * the `OTR_VIRTUAL_TIME` CMake option, which also wraps the libc time functions.
+ *
+ */
+#ifndef OTR_CONFIG_VIRTUAL_TIME_ENABLE
+#define OTR_CONFIG_VIRTUAL_TIME_ENABLE 0
+#endif
+
+/**
+ * @def OTR_CONFIG_VIRTUAL_TIME_POLL_INTERVAL
+ *
+ * The simulated time in milliseconds after which the main loop checks its file descriptors again when it has no
+ * earlier deadline.
+ *
+ */
+#ifndef OTR_CONFIG_VIRTUAL_TIME_POLL_INTERVAL
+#define OTR_CONFIG_VIRTUAL_TIME_POLL_INTERVAL 10
+#endif
+
+/**
+ * @def OTR_CONFIG_CACHE_LINE_SIZE
+ *
+ * The alignment used to keep data written by different tasks on separate cache lines.
+ *
+ */
+#ifndef OTR_CONFIG_CACHE_LINE_SIZE
+#if PLATFORM_linux
+#define OTR_CONFIG_CACHE_LINE_SIZE 64
+#else
+#define OTR_CONFIG_CACHE_LINE_SIZE 32
+#endif
+#endif
+
+/**
+ * @def OTR_CONFIG_MAIN_TASK_STACK_SIZE
+ *
+ * The stack size in words of the OpenThread main loop task of each instance.
+ *
+ */
+#ifndef OTR_CONFIG_MAIN_TASK_STACK_SIZE
+#define OTR_CONFIG_MAIN_TASK_STACK_SIZE 4096
+#endif
+
+/**
+ * @def OTR_CONFIG_MBEDTLS_ARENA_TLS_INDEX
+ *
+ * The FreeRTOS thread local storage pointer holding the mbedTLS arena of each task. Index 0 is taken by the lwIP
+ * per-thread semaphore, configNUM_THREAD_LOCAL_STORAGE_POINTERS must be larger than this index.
+ *
+ */
+#ifndef OTR_CONFIG_MBEDTLS_ARENA_TLS_INDEX
+#define OTR_CONFIG_MBEDTLS_ARENA_TLS_INDEX 1
+#endif
+
+/**
+ * @def OTR_CONFIG_MBEDTLS_POOL_CLASSES
+ *
+ * The size classes of the mbedTLS allocator as `X(block size, number of blocks)` entries, in ascending size. Block
+ * sizes must be multiples of 8. Requests larger than the last class, or made while every fitting class is exhausted,
+ * fall back to the heap.
+ *
+ * The default covers the many small allocations of a handshake in about 10 KB of static RAM on a 32-bit target. The
+ * record buffers and the larger certificate allocations stay on the heap. Larger classes are opt-in, size them from
+ * the handshake peaks reported by `otr tls` on the target.
+ *
+ */
+#ifndef OTR_CONFIG_MBEDTLS_POOL_CLASSES
+#define OTR_CONFIG_MBEDTLS_POOL_CLASSES(X) \
+    X(32, 32)                              \
+    X(64, 24)                              \
+    X(128, 16)                             \
+    X(256, 8)                              \
+    X(512, 4)
+#endif
+
+#endif // OTR_CONFIG_H_
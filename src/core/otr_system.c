@@ -31,46 +31,309 @@
 #if PLATFORM_linux
 
 #include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 
+#include <FreeRTOS.h>
+#include <task.h>
+
 #include <platform-posix.h>
 #include <openthread/tasklet.h>
 
+#include "otr_config.h"
+
+#define OTR_SYSTEM_MAX_EVENTS 8
+#define OTR_SYSTEM_MAX_FDS 8
+
 static struct otrSystemCtx
 {
-    fd_set read_fds;
-    fd_set write_fds;
-    fd_set error_fds;
-} sCtx;
+    fd_set   read_fds; // readiness handed to the platform
+    fd_set   write_fds;
+    fd_set   error_fds;
+    fd_set   interest_read_fds; // interest reported by the platform
+    fd_set   interest_write_fds;
+    fd_set   interest_error_fds;
+    fd_set   pollless_fds; // fds epoll refuses, e.g. a regular file as stdin, treated as always ready
+    int      epoll_fd;
+    int      wakeup_fd;
+    int      max_fd;
+    bool     consumed; // the readiness in the fd sets was already processed
+    uint8_t  num_fds;
+    int      fds[OTR_SYSTEM_MAX_FDS]; // the fds the platform reported, only their bits are ever set
+    uint32_t events[FD_SETSIZE];      // interest currently registered for each fd
+} sCtx = {.epoll_fd = -1, .wakeup_fd = -1, .max_fd = -1};
 
-void otrSystemPoll(otInstance *aInstance)
+static void systemFail(const char *aName)
+{
+    perror(aName);
+    exit(EXIT_FAILURE);
+}
+
+static void watchFd(int aFd)
+{
+    for (uint8_t i = 0; i < sCtx.num_fds; i++)
+    {
+        if (sCtx.fds[i] == aFd)
+        {
+            return;
+        }
+    }
+
+    if (sCtx.num_fds == OTR_SYSTEM_MAX_FDS)
+    {
+        fprintf(stderr, "otr_system: more than %d platform fds\n", OTR_SYSTEM_MAX_FDS);
+        exit(EXIT_FAILURE);
+    }
+
+    sCtx.fds[sCtx.num_fds++] = aFd;
+}
+
+static void clearFds(fd_set *aReadFds, fd_set *aWriteFds, fd_set *aErrorFds)
+{
+    for (uint8_t i = 0; i < sCtx.num_fds; i++)
+    {
+        FD_CLR(sCtx.fds[i], aReadFds);
+        FD_CLR(sCtx.fds[i], aWriteFds);
+        FD_CLR(sCtx.fds[i], aErrorFds);
+    }
+}
+
+static void updateInterest(int aFd, uint32_t aEvents)
+{
+    struct epoll_event event;
+    int                op;
+
+    if (sCtx.events[aFd] == aEvents)
+    {
+        return;
+    }
+
+    if (FD_ISSET(aFd, &sCtx.pollless_fds))
+    {
+        // The fd may be closed once the platform loses interest, its number may come back as a pollable fd.
+        if (aEvents == 0)
+        {
+            FD_CLR(aFd, &sCtx.pollless_fds);
+        }
+
+        sCtx.events[aFd] = aEvents;
+        return;
+    }
+
+    op            = (sCtx.events[aFd] == 0) ? EPOLL_CTL_ADD : ((aEvents == 0) ? EPOLL_CTL_DEL : EPOLL_CTL_MOD);
+    event.events  = aEvents;
+    event.data.fd = aFd;
+
+    if (epoll_ctl(sCtx.epoll_fd, op, aFd, &event) != 0)
+    {
+        if (op == EPOLL_CTL_DEL && (errno == EBADF || errno == ENOENT))
+        {
+            // The platform closed the fd before dropping it from its sets, epoll already forgot it.
+        }
+        else if (errno == EPERM)
+        {
+            FD_SET(aFd, &sCtx.pollless_fds);
+        }
+        else
+        {
+            systemFail("epoll_ctl");
+        }
+    }
+
+    sCtx.events[aFd] = aEvents;
+}
+
+static void setReady(int aFd, uint32_t aEvents)
+{
+    // Same readiness select() would report, a hangup or error makes the fd readable.
+    if (aEvents & (EPOLLIN | EPOLLERR | EPOLLHUP))
+    {
+        FD_SET(aFd, &sCtx.read_fds);
+    }
+
+    if (aEvents & EPOLLOUT)
+    {
+        FD_SET(aFd, &sCtx.write_fds);
+    }
+
+    if (aEvents & EPOLLPRI)
+    {
+        FD_SET(aFd, &sCtx.error_fds);
+    }
+}
+
+void otrSystemInit(void)
+{
+    struct epoll_event event;
+
+    sCtx.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (sCtx.epoll_fd < 0)
+    {
+        systemFail("epoll_create1");
+    }
+
+    sCtx.wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (sCtx.wakeup_fd < 0)
+    {
+        systemFail("eventfd");
+    }
+
+    event.events  = EPOLLIN;
+    event.data.fd = sCtx.wakeup_fd;
+    if (epoll_ctl(sCtx.epoll_fd, EPOLL_CTL_ADD, sCtx.wakeup_fd, &event) != 0)
+    {
+        systemFail("epoll_ctl");
+    }
+}
+
+void otrSystemWakeup(void)
 {
-    int            max_fd = -1;
-    struct timeval timeout;
-    int            rval;
+    uint64_t value = 1;
+    ssize_t  rval;
 
-    FD_ZERO(&sCtx.read_fds);
-    FD_ZERO(&sCtx.write_fds);
-    FD_ZERO(&sCtx.error_fds);
+    if (sCtx.wakeup_fd >= 0)
+    {
+        // Only fails when the counter is saturated, the main loop is then already due to wake up.
+        rval = write(sCtx.wakeup_fd, &value, sizeof(value));
+        (void)rval;
+    }
+}
 
-    platformUartUpdateFdSet(&sCtx.read_fds, &sCtx.write_fds, &sCtx.error_fds, &max_fd);
-    platformRadioUpdateFdSet(&sCtx.read_fds, &sCtx.write_fds, &max_fd);
+static void pollEvents(otInstance *aInstance, bool aBlock)
+{
+    struct epoll_event events[OTR_SYSTEM_MAX_EVENTS];
+    struct timeval     timeout;
+    int                max_fd      = -1;
+    int                waitTime    = 0;
+    bool               hasPollless = false;
+    int                rval;
+
+    // The platform reports its interest through fd sets. Only the bits of its known fds are cleared and checked,
+    // and only the differences reach epoll.
+    clearFds(&sCtx.interest_read_fds, &sCtx.interest_write_fds, &sCtx.interest_error_fds);
+
+    platformUartUpdateFdSet(&sCtx.interest_read_fds, &sCtx.interest_write_fds, &sCtx.interest_error_fds, &max_fd);
+    platformRadioUpdateFdSet(&sCtx.interest_read_fds, &sCtx.interest_write_fds, &max_fd);
     platformAlarmUpdateTimeout(&timeout);
 
-    if (!otTaskletsArePending(aInstance))
+    // The UART and radio fds are fixed once opened, look for new ones only when the highest fd changes.
+    if (max_fd != sCtx.max_fd)
     {
-        rval = select(max_fd + 1, &sCtx.read_fds, &sCtx.write_fds, &sCtx.error_fds, &timeout);
+        for (int fd = 0; fd <= max_fd; fd++)
+        {
+            if (FD_ISSET(fd, &sCtx.interest_read_fds) || FD_ISSET(fd, &sCtx.interest_write_fds) ||
+                FD_ISSET(fd, &sCtx.interest_error_fds))
+            {
+                watchFd(fd);
+            }
+        }
+
+        sCtx.max_fd = max_fd;
+    }
 
-        if ((rval < 0) && (errno != EINTR))
+    for (uint8_t i = 0; i < sCtx.num_fds; i++)
+    {
+        int      fd       = sCtx.fds[i];
+        uint32_t interest = 0;
+
+        if (FD_ISSET(fd, &sCtx.interest_read_fds))
+        {
+            interest |= EPOLLIN;
+        }
+
+        if (FD_ISSET(fd, &sCtx.interest_write_fds))
+        {
+            interest |= EPOLLOUT;
+        }
+
+        if (FD_ISSET(fd, &sCtx.interest_error_fds))
         {
-            perror("select");
-            exit(EXIT_FAILURE);
+            interest |= EPOLLPRI;
         }
+
+        updateInterest(fd, interest);
+        hasPollless = hasPollless || (interest != 0 && FD_ISSET(fd, &sCtx.pollless_fds));
+    }
+
+    if (aBlock && !otTaskletsArePending(aInstance) && !hasPollless)
+    {
+        waitTime = (int)(timeout.tv_sec * 1000 + (timeout.tv_usec + 999) / 1000);
     }
+
+#if OTR_CONFIG_VIRTUAL_TIME_ENABLE
+    // Time only moves while every task is blocked in FreeRTOS, wait there rather than in the kernel.
+    rval = epoll_wait(sCtx.epoll_fd, events, OTR_SYSTEM_MAX_EVENTS, 0);
+
+    if (rval == 0 && waitTime > 0)
+    {
+        if (waitTime > OTR_CONFIG_VIRTUAL_TIME_POLL_INTERVAL)
+        {
+            waitTime = OTR_CONFIG_VIRTUAL_TIME_POLL_INTERVAL;
+        }
+
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitTime));
+    }
+#else
+    rval = epoll_wait(sCtx.epoll_fd, events, OTR_SYSTEM_MAX_EVENTS, waitTime);
+#endif
+
+    if ((rval < 0) && (errno != EINTR))
+    {
+        systemFail("epoll_wait");
+    }
+
+    clearFds(&sCtx.read_fds, &sCtx.write_fds, &sCtx.error_fds);
+
+    for (int i = 0; i < rval; i++)
+    {
+        if (events[i].data.fd == sCtx.wakeup_fd)
+        {
+            uint64_t value;
+            ssize_t  drained;
+
+            // Only a blocking poll serves the notifications, a service poll leaves them for the next one.
+            if (aBlock)
+            {
+                drained = read(sCtx.wakeup_fd, &value, sizeof(value));
+                (void)drained;
+            }
+        }
+        else
+        {
+            setReady(events[i].data.fd, events[i].events);
+        }
+    }
+
+    for (uint8_t i = 0; hasPollless && i < sCtx.num_fds; i++)
+    {
+        if (FD_ISSET(sCtx.fds[i], &sCtx.pollless_fds))
+        {
+            setReady(sCtx.fds[i], sCtx.events[sCtx.fds[i]] & (EPOLLIN | EPOLLOUT));
+        }
+    }
+
+    sCtx.consumed = false;
+}
+
+void otrSystemPoll(otInstance *aInstance)
+{
+    pollEvents(aInstance, true);
 }
 
 void otrSystemProcess(otInstance *aInstance)
 {
+    // Called again before the next otrSystemPoll(), fetch fresh readiness rather than replaying the old one.
+    if (sCtx.consumed)
+    {
+        pollEvents(aInstance, false);
+    }
+
+    sCtx.consumed = true;
     platformUartProcess();
     platformRadioProcess(aInstance, &sCtx.read_fds, &sCtx.write_fds);
     platformAlarmProcess(aInstance);
@@ -84,6 +347,10 @@ void otrSystemProcess(otInstance *aInstance)
 #include <openthread-system.h>
 #include <openthread/tasklet.h>
 
+void otrSystemInit(void)
+{
+}
+
 void otrSystemPoll(otInstance *aInstance)
 {
     if (!otTaskletsArePending(aInstance))
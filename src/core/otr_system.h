@@ -35,6 +35,19 @@ extern "C" {
 
 #include <openthread/instance.h>
 
+/**
+ * This function initializes the system event sources, must be called before the main loop starts.
+ *
+ */
+void otrSystemInit(void);
+
+/**
+ * This function wakes up a main loop blocked in otrSystemPoll(), on platforms that do not use task
+ * notifications for it. It may be called from any task.
+ *
+ */
+void otrSystemWakeup(void);
+
 /**
  * This function waits for a system event
  *
@@ -46,6 +59,8 @@ void otrSystemPoll(otInstance *aInstance);
 /**
  * This function performs system level process
  *
+ * It may be called more than once per otrSystemPoll(), later calls check for new events without blocking.
+ *
  *  @param[in] aInstance  OpenThread instance
  *
  */
@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "profiler.h"
+
+#if OTR_CONFIG_PROFILER_ENABLE
+
+static const char *const sPhaseNames[OTR_PROFILER_NUM_PHASES] = {
+    "commands", "tasklets", "poll", "lock wait", "process", "netif tx", "netif rx",
+};
+
+void profilerInit(void)
+{
+    OTR_PORT_CYCLE_COUNTER_INIT();
+}
+
+void profilerRecord(otrProfilerStats *aStats, uint8_t aPhase, uint32_t aCycles)
+{
+    otrProfilerPhaseStats *phase   = &aStats->mPhases[aPhase];
+    uint32_t               elapsed = aCycles / OTR_PORT_CYCLES_PER_US;
+    uint8_t                bucket  = 0;
+
+    if (elapsed != 0)
+    {
+        bucket = (uint8_t)(32 - __builtin_clz(elapsed));
+
+        if (bucket >= OTR_PROFILER_BUCKETS)
+        {
+            bucket = OTR_PROFILER_BUCKETS - 1;
+        }
+    }
+
+    phase->mCount++;
+    phase->mTotalUs += elapsed;
+    phase->mHistogram[bucket]++;
+
+    if (elapsed > phase->mMaxUs)
+    {
+        phase->mMaxUs = elapsed;
+    }
+}
+
+const char *profilerPhaseName(uint8_t aPhase)
+{
+    return aPhase < OTR_PROFILER_NUM_PHASES ? sPhaseNames[aPhase] : "unknown";
+}
+
+#endif // OTR_CONFIG_PROFILER_ENABLE
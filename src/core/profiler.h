@@ -0,0 +1,150 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OTR_PROFILER_H_
+#define OTR_PROFILER_H_
+
+#include <stdint.h>
+
+#include <openthread/instance.h>
+
+#include "otr_config.h"
+#include "portable/portable.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The number of buckets in each phase histogram.
+ *
+ */
+#define OTR_PROFILER_BUCKETS 20
+
+/**
+ * The phases of the OpenThread main loop.
+ *
+ */
+enum
+{
+    OTR_PROFILER_PHASE_COMMANDS,  ///< Posted commands, see otrCommandPost().
+    OTR_PROFILER_PHASE_TASKLETS,  ///< otTaskletsProcess().
+    OTR_PROFILER_PHASE_POLL,      ///< otrSystemPoll(), only active time on nrf52.
+    OTR_PROFILER_PHASE_LOCK_WAIT, ///< Taking the external lock back after the poll.
+    OTR_PROFILER_PHASE_PROCESS,   ///< otrSystemProcess(), the radio and platform drivers.
+    OTR_PROFILER_PHASE_NETIF_TX,  ///< netifProcessTransmit().
+    OTR_PROFILER_PHASE_NETIF_RX,  ///< netifProcessReceive().
+    OTR_PROFILER_NUM_PHASES,
+};
+
+/**
+ * This structure represents the timing of one main loop phase.
+ *
+ */
+typedef struct otrProfilerPhaseStats
+{
+    uint32_t mCount;   ///< Times the phase ran.
+    uint32_t mMaxUs;   ///< The longest run, in microseconds.
+    uint64_t mTotalUs; ///< The total time spent in the phase, in microseconds.
+
+    /**
+     * Bucket 0 counts runs shorter than a microsecond, bucket n counts [2^(n-1), 2^n) us and the last bucket
+     * everything above.
+     *
+     */
+    uint32_t mHistogram[OTR_PROFILER_BUCKETS];
+} otrProfilerPhaseStats;
+
+/**
+ * This structure represents the timing of all main loop phases of an instance.
+ *
+ */
+typedef struct otrProfilerStats
+{
+    otrProfilerPhaseStats mPhases[OTR_PROFILER_NUM_PHASES];
+} otrProfilerStats;
+
+/**
+ * This function starts the cycle counter used by the profiler.
+ *
+ */
+void profilerInit(void);
+
+/**
+ * This function accounts one run of a phase.
+ *
+ * @param[inout]  aStats    The statistics to update.
+ * @param[in]     aPhase    The phase.
+ * @param[in]     aCycles   The duration, in cycle counter units.
+ *
+ */
+void profilerRecord(otrProfilerStats *aStats, uint8_t aPhase, uint32_t aCycles);
+
+/**
+ * This function returns the name of a phase.
+ *
+ */
+const char *profilerPhaseName(uint8_t aPhase);
+
+/**
+ * This function copies the main loop profile of an instance, it must be called from the OpenThread task.
+ *
+ */
+void profilerGetStats(otInstance *aInstance, otrProfilerStats *aStats);
+
+/**
+ * This function clears the main loop profile of an instance, it must be called from the OpenThread task.
+ *
+ */
+void profilerResetStats(otInstance *aInstance);
+
+#if OTR_CONFIG_PROFILER_ENABLE
+/**
+ * This macro runs a statement and accounts its duration to a phase.
+ *
+ */
+#define OTR_PROFILE(aStats, aPhase, ...)                                       \
+    do                                                                         \
+    {                                                                          \
+        uint32_t profileStart = OTR_PORT_GET_CYCLES();                         \
+        __VA_ARGS__;                                                           \
+        profilerRecord(aStats, aPhase, OTR_PORT_GET_CYCLES() - profileStart); \
+    } while (0)
+#else
+#define OTR_PROFILE(aStats, aPhase, ...) \
+    do                                   \
+    {                                    \
+        __VA_ARGS__;                     \
+    } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OTR_PROFILER_H_
@@ -0,0 +1,124 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "scheduler.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "otr_config.h"
+#include "portable/portable.h"
+
+static uint32_t runPhase(otrScheduler *aScheduler, uint8_t aIndex, otInstance *aInstance)
+{
+    const otrSchedulerPhase *phase = aScheduler->mPhases[aIndex];
+    otrSchedulerPhaseStats * stats = &aScheduler->mStats.mPhases[aIndex];
+    uint32_t                 start = OTR_PORT_GET_CYCLES();
+    uint32_t                 end;
+    uint32_t                 elapsed;
+
+    phase->mHandler(aInstance);
+
+    end     = OTR_PORT_GET_CYCLES();
+    elapsed = (end - start) / OTR_PORT_CYCLES_PER_US;
+
+    stats->mRuns++;
+
+    if (elapsed > phase->mBudgetUs)
+    {
+        stats->mMisses++;
+    }
+
+    if (elapsed > stats->mMaxUs)
+    {
+        stats->mMaxUs = elapsed;
+    }
+
+#if OTR_CONFIG_PROFILER_ENABLE
+    if (aScheduler->mProfile != NULL)
+    {
+        profilerRecord(aScheduler->mProfile, phase->mProfilerPhase, end - start);
+    }
+#endif
+
+    return end;
+}
+
+void schedulerInit(otrScheduler *           aScheduler,
+                   const otrSchedulerPhase *aPhases,
+                   uint8_t                  aNumPhases,
+                   otrProfilerStats *       aProfile)
+{
+    assert(aNumPhases > 0 && aNumPhases <= OTR_SCHEDULER_MAX_PHASES);
+
+    memset(aScheduler, 0, sizeof(*aScheduler));
+    aScheduler->mProfile = aProfile;
+
+    // Stable insertion sort, phases of equal priority keep their table order.
+    for (uint8_t i = 0; i < aNumPhases; i++)
+    {
+        uint8_t j = i;
+
+        while (j > 0 && aScheduler->mPhases[j - 1]->mPriority > aPhases[i].mPriority)
+        {
+            aScheduler->mPhases[j] = aScheduler->mPhases[j - 1];
+            j--;
+        }
+
+        aScheduler->mPhases[j] = &aPhases[i];
+    }
+
+    aScheduler->mStats.mNumPhases = aNumPhases;
+
+    for (uint8_t i = 0; i < aNumPhases; i++)
+    {
+        aScheduler->mStats.mPhases[i].mName     = aScheduler->mPhases[i]->mName;
+        aScheduler->mStats.mPhases[i].mPriority = aScheduler->mPhases[i]->mPriority;
+        aScheduler->mStats.mPhases[i].mBudgetUs = aScheduler->mPhases[i]->mBudgetUs;
+    }
+
+    OTR_PORT_CYCLE_COUNTER_INIT();
+}
+
+void schedulerRun(otrScheduler *aScheduler, otInstance *aInstance)
+{
+    const uint32_t interval   = OTR_CONFIG_SCHEDULER_SYSTEM_INTERVAL * OTR_PORT_CYCLES_PER_US;
+    uint32_t       lastSystem = runPhase(aScheduler, 0, aInstance);
+
+    for (uint8_t i = 1; i < aScheduler->mStats.mNumPhases; i++)
+    {
+        uint32_t end = runPhase(aScheduler, i, aInstance);
+
+        // Cooperative pre-emption, the drivers get their turn back before the next phase.
+        if (i + 1 < aScheduler->mStats.mNumPhases && end - lastSystem >= interval)
+        {
+            aScheduler->mStats.mPreemptions++;
+            lastSystem = runPhase(aScheduler, 0, aInstance);
+        }
+    }
+}
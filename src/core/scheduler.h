@@ -0,0 +1,150 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OTR_SCHEDULER_H_
+#define OTR_SCHEDULER_H_
+
+#include <stdint.h>
+
+#include <openthread/instance.h>
+
+#include "profiler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The maximum number of phases in a main loop pass.
+ *
+ */
+#define OTR_SCHEDULER_MAX_PHASES 8
+
+/**
+ * This function pointer runs one main loop phase.
+ *
+ * A phase that leaves work behind, because it used up its work budget, notifies the main loop again so that the
+ * next poll does not block.
+ *
+ * @param[in]  aInstance  A pointer to the OpenThread instance.
+ *
+ */
+typedef void (*otrSchedulerHandler)(otInstance *aInstance);
+
+/**
+ * This structure represents a main loop phase.
+ *
+ */
+typedef struct otrSchedulerPhase
+{
+    const char *        mName;          ///< The name shown by `otr sched`.
+    otrSchedulerHandler mHandler;       ///< Runs the phase.
+    uint8_t             mPriority;      ///< Lower values run first, the first phase is serviced pre-emptively.
+    uint32_t            mBudgetUs;      ///< Runs longer than this are deadline misses.
+    uint8_t             mProfilerPhase; ///< Where the run time is accounted when the profiler is enabled.
+} otrSchedulerPhase;
+
+/**
+ * This structure represents the statistics of a main loop phase.
+ *
+ */
+typedef struct otrSchedulerPhaseStats
+{
+    const char *mName;     ///< The name of the phase.
+    uint8_t     mPriority; ///< The priority of the phase.
+    uint32_t    mBudgetUs; ///< The time budget of the phase.
+    uint32_t    mRuns;     ///< Times the phase ran.
+    uint32_t    mMisses;   ///< Runs that took longer than `mBudgetUs`.
+    uint32_t    mMaxUs;    ///< The longest run, in microseconds.
+} otrSchedulerPhaseStats;
+
+/**
+ * This structure represents the statistics of the main loop scheduler of an instance.
+ *
+ */
+typedef struct otrSchedulerStats
+{
+    uint8_t                mNumPhases;   ///< The number of valid entries in `mPhases`.
+    uint32_t               mPreemptions; ///< Extra runs of the first phase between the others.
+    otrSchedulerPhaseStats mPhases[OTR_SCHEDULER_MAX_PHASES]; ///< Per phase, in run order.
+} otrSchedulerStats;
+
+/**
+ * This structure represents the main loop scheduler of an instance.
+ *
+ */
+typedef struct otrScheduler
+{
+    const otrSchedulerPhase *mPhases[OTR_SCHEDULER_MAX_PHASES]; ///< Sorted by priority.
+    otrSchedulerStats        mStats;
+    otrProfilerStats *       mProfile;
+} otrScheduler;
+
+/**
+ * This function initializes a scheduler.
+ *
+ * @param[out]  aScheduler   A pointer to the scheduler.
+ * @param[in]   aPhases      The phases, they must outlive the scheduler.
+ * @param[in]   aNumPhases   The number of phases.
+ * @param[in]   aProfile     Where run times are accounted when the profiler is enabled, may be NULL.
+ *
+ */
+void schedulerInit(otrScheduler *           aScheduler,
+                   const otrSchedulerPhase *aPhases,
+                   uint8_t                  aNumPhases,
+                   otrProfilerStats *       aProfile);
+
+/**
+ * This function runs one main loop pass, every phase once in priority order.
+ *
+ * The first phase also runs between two later ones once `OTR_CONFIG_SCHEDULER_SYSTEM_INTERVAL` has passed since
+ * its last run.
+ *
+ * @param[inout]  aScheduler  A pointer to the scheduler.
+ * @param[in]     aInstance   A pointer to the OpenThread instance.
+ *
+ */
+void schedulerRun(otrScheduler *aScheduler, otInstance *aInstance);
+
+/**
+ * This function copies the scheduler statistics of an instance, it must be called from the OpenThread task.
+ *
+ */
+void schedulerGetStats(otInstance *aInstance, otrSchedulerStats *aStats);
+
+/**
+ * This function clears the scheduler statistics of an instance, it must be called from the OpenThread task.
+ *
+ */
+void schedulerResetStats(otInstance *aInstance);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OTR_SCHEDULER_H_
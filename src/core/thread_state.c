@@ -0,0 +1,187 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "thread_state.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include <event_groups.h>
+
+#include "otr_config.h"
+
+typedef struct ThreadStateContext
+{
+    otInstance *       mInstance;
+    EventGroupHandle_t mEvents;
+
+    /**
+     * The snapshot is double buffered, `mStates[mVersion & 1]` is the published one. The OpenThread task writes
+     * the other buffer and then bumps `mVersion`, so a published snapshot is never written while it is current.
+     * A reader retries if `mVersion` moved while it copied.
+     *
+     */
+    uint32_t       mVersion;
+    otrThreadState mStates[2];
+#if configSUPPORT_STATIC_ALLOCATION
+    StaticEventGroup_t mEventsBuffer;
+#endif
+} ThreadStateContext;
+
+static ThreadStateContext sContexts[OTR_CONFIG_MAX_INSTANCES];
+static uint8_t            sNumContexts = 0;
+
+static ThreadStateContext *getContext(otInstance *aInstance)
+{
+    ThreadStateContext *context = NULL;
+
+    for (uint8_t i = 0; i < sNumContexts; i++)
+    {
+        if (sContexts[i].mInstance == aInstance)
+        {
+            context = &sContexts[i];
+            break;
+        }
+    }
+
+    return context;
+}
+
+static bool isGlobalAddress(const otIp6Address *aAddress, const otMeshLocalPrefix *aMeshLocalPrefix)
+{
+    bool linkLocal = aAddress->mFields.m8[0] == 0xfe && (aAddress->mFields.m8[1] & 0xc0) == 0x80;
+    bool meshLocal = memcmp(aAddress->mFields.m8, aMeshLocalPrefix->m8, sizeof(aMeshLocalPrefix->m8)) == 0;
+
+    return !linkLocal && !meshLocal;
+}
+
+static void collectState(otInstance *aInstance, otrThreadState *aState)
+{
+    memset(aState, 0, sizeof(*aState));
+
+    aState->mRole            = otThreadGetDeviceRole(aInstance);
+    aState->mRloc16          = otThreadGetRloc16(aInstance);
+    aState->mPartitionId     = otThreadGetPartitionId(aInstance);
+    aState->mMeshLocalPrefix = *otThreadGetMeshLocalPrefix(aInstance);
+
+    for (const otNetifAddress *addr = otIp6GetUnicastAddresses(aInstance); addr != NULL; addr = addr->mNext)
+    {
+        if (aState->mNumGlobalAddresses < OTR_THREAD_STATE_MAX_GLOBAL_ADDRESSES &&
+            isGlobalAddress(&addr->mAddress, &aState->mMeshLocalPrefix))
+        {
+            aState->mGlobalAddresses[aState->mNumGlobalAddresses++] = addr->mAddress;
+        }
+    }
+}
+
+static void publishState(ThreadStateContext *aContext)
+{
+    uint32_t        version = aContext->mVersion;
+    otrThreadState *state   = &aContext->mStates[(version + 1) & 1];
+    EventBits_t     events  = 0;
+
+    collectState(aContext->mInstance, state);
+    __atomic_store_n(&aContext->mVersion, version + 1, __ATOMIC_RELEASE);
+
+    if (state->mRole >= OT_DEVICE_ROLE_CHILD)
+    {
+        events |= OTR_THREAD_STATE_ATTACHED;
+    }
+
+    if (state->mNumGlobalAddresses > 0)
+    {
+        events |= OTR_THREAD_STATE_GLOBAL_ADDRESS;
+    }
+
+    xEventGroupClearBits(aContext->mEvents, ~events & (OTR_THREAD_STATE_ATTACHED | OTR_THREAD_STATE_GLOBAL_ADDRESS));
+    xEventGroupSetBits(aContext->mEvents, events);
+}
+
+static void processStateChange(otChangedFlags aFlags, void *aContext)
+{
+    const otChangedFlags kStateFlags = OT_CHANGED_THREAD_ROLE | OT_CHANGED_THREAD_RLOC_ADDED |
+                                       OT_CHANGED_THREAD_PARTITION_ID | OT_CHANGED_THREAD_ML_ADDR |
+                                       OT_CHANGED_IP6_ADDRESS_ADDED | OT_CHANGED_IP6_ADDRESS_REMOVED;
+
+    if (aFlags & kStateFlags)
+    {
+        publishState((ThreadStateContext *)aContext);
+    }
+}
+
+void threadStateInit(otInstance *aInstance)
+{
+    ThreadStateContext *context;
+    otError             error;
+
+    assert(sNumContexts < OTR_CONFIG_MAX_INSTANCES);
+    context = &sContexts[sNumContexts];
+
+    context->mInstance = aInstance;
+#if configSUPPORT_STATIC_ALLOCATION
+    context->mEvents = xEventGroupCreateStatic(&context->mEventsBuffer);
+#else
+    context->mEvents = xEventGroupCreate();
+#endif
+    assert(context->mEvents != NULL);
+
+    context->mVersion = 0;
+    publishState(context);
+    sNumContexts++;
+
+    error = otSetStateChangedCallback(aInstance, processStateChange, context);
+    assert(error == OT_ERROR_NONE);
+    (void)error;
+}
+
+void threadStateGet(otInstance *aInstance, otrThreadState *aState)
+{
+    ThreadStateContext *context = getContext(aInstance);
+    uint32_t            version;
+
+    assert(context != NULL);
+
+    do
+    {
+        version = __atomic_load_n(&context->mVersion, __ATOMIC_ACQUIRE);
+        *aState = context->mStates[version & 1];
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (version != __atomic_load_n(&context->mVersion, __ATOMIC_RELAXED));
+}
+
+bool threadStateWait(otInstance *aInstance, uint32_t aFlags, TickType_t aTimeout)
+{
+    ThreadStateContext *context = getContext(aInstance);
+    EventBits_t         events;
+
+    assert(context != NULL);
+
+    events = xEventGroupWaitBits(context->mEvents, (EventBits_t)aFlags, pdFALSE, pdTRUE, aTimeout);
+
+    return (events & aFlags) == aFlags;
+}
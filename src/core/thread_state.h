@@ -0,0 +1,114 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OTR_THREAD_STATE_H_
+#define OTR_THREAD_STATE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <FreeRTOS.h>
+
+#include <openthread/instance.h>
+#include <openthread/ip6.h>
+#include <openthread/thread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The number of global unicast addresses kept in a Thread state snapshot.
+ *
+ */
+#define OTR_THREAD_STATE_MAX_GLOBAL_ADDRESSES 4
+
+/**
+ * The device is attached, as a child, router or leader.
+ *
+ */
+#define OTR_THREAD_STATE_ATTACHED (1 << 0)
+
+/**
+ * The device has at least one global unicast address.
+ *
+ */
+#define OTR_THREAD_STATE_GLOBAL_ADDRESS (1 << 1)
+
+/**
+ * This structure represents a consistent snapshot of the Thread network state of an instance.
+ *
+ */
+typedef struct otrThreadState
+{
+    otDeviceRole      mRole;               ///< The device role.
+    uint16_t          mRloc16;             ///< The RLOC16.
+    uint32_t          mPartitionId;        ///< The partition ID.
+    otMeshLocalPrefix mMeshLocalPrefix;    ///< The mesh-local prefix.
+    uint8_t           mNumGlobalAddresses; ///< The number of valid entries in `mGlobalAddresses`.
+    otIp6Address      mGlobalAddresses[OTR_THREAD_STATE_MAX_GLOBAL_ADDRESSES]; ///< Unicast addresses that are
+                                                                               ///< neither link- nor mesh-local.
+} otrThreadState;
+
+/**
+ * This function starts publishing the Thread state of an instance, it must run before the instance task starts.
+ *
+ * @param[in]  aInstance  A pointer to the OpenThread instance.
+ *
+ */
+void threadStateInit(otInstance *aInstance);
+
+/**
+ * This function reads the latest Thread state snapshot of an instance.
+ *
+ * The snapshot is published by the OpenThread task whenever the state changes. Reading it takes no lock and never
+ * wakes the OpenThread task.
+ *
+ * @param[in]   aInstance  A pointer to the OpenThread instance.
+ * @param[out]  aState     Where the snapshot is copied.
+ *
+ */
+void threadStateGet(otInstance *aInstance, otrThreadState *aState);
+
+/**
+ * This function blocks until all given conditions hold for an instance.
+ *
+ * @param[in]  aInstance  A pointer to the OpenThread instance.
+ * @param[in]  aFlags     A combination of `OTR_THREAD_STATE_*` conditions.
+ * @param[in]  aTimeout   The maximum time to wait, in ticks.
+ *
+ * @returns true if the conditions hold, false on timeout.
+ *
+ */
+bool threadStateWait(otInstance *aInstance, uint32_t aFlags, TickType_t aTimeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OTR_THREAD_STATE_H_
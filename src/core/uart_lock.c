@@ -35,10 +35,17 @@
  * UART Lock
  */
 static xSemaphoreHandle sUartMtx;
+#if configSUPPORT_STATIC_ALLOCATION
+static StaticSemaphore_t sUartMtxBuffer;
+#endif
 
 otError otrUartLockInit(void)
 {
+#if configSUPPORT_STATIC_ALLOCATION
+    sUartMtx = xSemaphoreCreateMutexStatic(&sUartMtxBuffer);
+#else
     sUartMtx = xSemaphoreCreateMutex();
+#endif
     return OT_ERROR_NONE;
 }
 
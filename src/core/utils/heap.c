@@ -0,0 +1,266 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "heap.h"
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+// Precedes every allocation, keeping the returned memory aligned as malloc() would.
+typedef union Header
+{
+    struct
+    {
+        size_t  mSize;
+        uint8_t mTag;
+    } mInfo;
+    max_align_t mAlign;
+} Header;
+
+static otrHeapStats sStats[OTR_HEAP_NUM_TAGS];
+
+static const char *const sTagNames[OTR_HEAP_NUM_TAGS] = {"ot", "lwip", "mbedtls", "json", "app"};
+
+static void charge(otrHeapTag aTag, size_t aSize)
+{
+    otrHeapStats *stats = &sStats[aTag];
+
+    taskENTER_CRITICAL();
+    stats->mAllocs++;
+    stats->mLiveBytes += aSize;
+
+    if (stats->mLiveBytes > stats->mPeakBytes)
+    {
+        stats->mPeakBytes = stats->mLiveBytes;
+    }
+    taskEXIT_CRITICAL();
+}
+
+static void uncharge(otrHeapTag aTag, size_t aSize)
+{
+    taskENTER_CRITICAL();
+    sStats[aTag].mFrees++;
+    sStats[aTag].mLiveBytes -= aSize;
+    taskEXIT_CRITICAL();
+}
+
+static void fail(otrHeapTag aTag, size_t aSize)
+{
+    otrHeapStats *stats = &sStats[aTag];
+
+    taskENTER_CRITICAL();
+    stats->mFailures++;
+
+    if (aSize > stats->mLargestFailure)
+    {
+        stats->mLargestFailure = aSize;
+    }
+    taskEXIT_CRITICAL();
+
+    printf("heap: %s failed to allocate %lu bytes\r\n", sTagNames[aTag], (unsigned long)aSize);
+    otrHeapDump();
+}
+
+void *otrHeapMalloc(otrHeapTag aTag, size_t aSize)
+{
+    Header *header = NULL;
+
+    if (aSize <= SIZE_MAX - sizeof(Header))
+    {
+        header = malloc(sizeof(Header) + aSize);
+    }
+
+    if (header == NULL)
+    {
+        fail(aTag, aSize);
+        return NULL;
+    }
+
+    header->mInfo.mSize = aSize;
+    header->mInfo.mTag  = aTag;
+    charge(aTag, aSize);
+
+    return header + 1;
+}
+
+void *otrHeapCalloc(otrHeapTag aTag, size_t aCount, size_t aSize)
+{
+    size_t size    = aCount * aSize;
+    void * pointer = NULL;
+
+    if (aSize != 0 && size / aSize != aCount)
+    {
+        fail(aTag, SIZE_MAX);
+    }
+    else if ((pointer = otrHeapMalloc(aTag, size)) != NULL)
+    {
+        memset(pointer, 0, size);
+    }
+
+    return pointer;
+}
+
+void *otrHeapRealloc(otrHeapTag aTag, void *aPointer, size_t aSize)
+{
+    Header *header;
+    size_t  oldSize;
+
+    if (aPointer == NULL)
+    {
+        return otrHeapMalloc(aTag, aSize);
+    }
+
+    header  = (Header *)aPointer - 1;
+    aTag    = (otrHeapTag)header->mInfo.mTag;
+    oldSize = header->mInfo.mSize;
+
+    if (aSize > SIZE_MAX - sizeof(Header) || (header = realloc(header, sizeof(Header) + aSize)) == NULL)
+    {
+        fail(aTag, aSize);
+        return NULL;
+    }
+
+    header->mInfo.mSize = aSize;
+
+    taskENTER_CRITICAL();
+    sStats[aTag].mLiveBytes = sStats[aTag].mLiveBytes - oldSize + aSize;
+
+    if (sStats[aTag].mLiveBytes > sStats[aTag].mPeakBytes)
+    {
+        sStats[aTag].mPeakBytes = sStats[aTag].mLiveBytes;
+    }
+    taskEXIT_CRITICAL();
+
+    return header + 1;
+}
+
+void otrHeapFree(void *aPointer)
+{
+    Header *header = (Header *)aPointer - 1;
+
+    if (aPointer == NULL)
+    {
+        return;
+    }
+
+    uncharge((otrHeapTag)header->mInfo.mTag, header->mInfo.mSize);
+    free(header);
+}
+
+void otrHeapGetStats(otrHeapTag aTag, otrHeapStats *aStats)
+{
+    taskENTER_CRITICAL();
+    *aStats = sStats[aTag];
+    taskEXIT_CRITICAL();
+}
+
+void otrHeapResetStats(void)
+{
+    taskENTER_CRITICAL();
+    for (uint8_t i = 0; i < OTR_HEAP_NUM_TAGS; i++)
+    {
+        sStats[i].mPeakBytes      = sStats[i].mLiveBytes;
+        sStats[i].mAllocs         = 0;
+        sStats[i].mFrees          = 0;
+        sStats[i].mFailures       = 0;
+        sStats[i].mLargestFailure = 0;
+    }
+    taskEXIT_CRITICAL();
+}
+
+const char *otrHeapTagName(otrHeapTag aTag)
+{
+    return sTagNames[aTag];
+}
+
+void otrHeapDump(void)
+{
+    for (uint8_t i = 0; i < OTR_HEAP_NUM_TAGS; i++)
+    {
+        otrHeapStats stats;
+
+        otrHeapGetStats((otrHeapTag)i, &stats);
+        printf("heap: %s: live: %lu peak: %lu allocs: %lu frees: %lu failures: %lu largest failure: %lu\r\n",
+               sTagNames[i], (unsigned long)stats.mLiveBytes, (unsigned long)stats.mPeakBytes,
+               (unsigned long)stats.mAllocs, (unsigned long)stats.mFrees, (unsigned long)stats.mFailures,
+               (unsigned long)stats.mLargestFailure);
+    }
+}
+
+static void *mallocBare(otrHeapTag aTag, size_t aSize)
+{
+    // No header, libjwt frees some of these blocks with free(). The usable size is charged as it is known on free.
+    void *pointer = malloc(aSize);
+
+    if (pointer == NULL)
+    {
+        fail(aTag, aSize);
+    }
+    else
+    {
+        charge(aTag, malloc_usable_size(pointer));
+    }
+
+    return pointer;
+}
+
+static void freeBare(otrHeapTag aTag, void *aPointer)
+{
+    if (aPointer == NULL)
+    {
+        return;
+    }
+
+    uncharge(aTag, malloc_usable_size(aPointer));
+    free(aPointer);
+}
+
+void *otrHeapJsonMalloc(size_t aSize)
+{
+    return mallocBare(OTR_HEAP_TAG_JSON, aSize);
+}
+
+void otrHeapJsonFree(void *aPointer)
+{
+    freeBare(OTR_HEAP_TAG_JSON, aPointer);
+}
+
+void *otrHeapAppMalloc(size_t aSize)
+{
+    return mallocBare(OTR_HEAP_TAG_APP, aSize);
+}
+
+void otrHeapAppFree(void *aPointer)
+{
+    freeBare(OTR_HEAP_TAG_APP, aPointer);
+}
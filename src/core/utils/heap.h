@@ -0,0 +1,191 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OTR_HEAP_H_
+#define OTR_HEAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The subsystems heap allocations are charged to.
+ *
+ */
+typedef enum otrHeapTag
+{
+    OTR_HEAP_TAG_OT,      ///< The OpenThread glue.
+    OTR_HEAP_TAG_LWIP,    ///< lwIP, through mem_clib_malloc().
+    OTR_HEAP_TAG_MBEDTLS, ///< mbedTLS requests its pools cannot serve.
+    OTR_HEAP_TAG_JSON,    ///< jansson, through json_set_alloc_funcs().
+    OTR_HEAP_TAG_APP,     ///< The applications, and the signatures libjwt makes with mbedTLS.
+    OTR_HEAP_NUM_TAGS,
+} otrHeapTag;
+
+/**
+ * This structure represents the heap usage of one subsystem.
+ *
+ */
+typedef struct otrHeapStats
+{
+    size_t   mLiveBytes;      ///< Bytes currently allocated.
+    size_t   mPeakBytes;      ///< The most bytes allocated at once.
+    uint32_t mAllocs;         ///< Successful allocations.
+    uint32_t mFrees;          ///< Frees.
+    uint32_t mFailures;       ///< Failed allocations.
+    size_t   mLargestFailure; ///< The size of the largest failed allocation.
+} otrHeapStats;
+
+/**
+ * This function allocates memory charged to a subsystem.
+ *
+ * The memory must be released with otrHeapFree(), never with free().
+ *
+ * @param[in]  aTag   The subsystem.
+ * @param[in]  aSize  The size in bytes.
+ *
+ * @returns A pointer to the memory, or NULL if the heap is exhausted.
+ *
+ */
+void *otrHeapMalloc(otrHeapTag aTag, size_t aSize);
+
+/**
+ * This function allocates zeroed memory charged to a subsystem.
+ *
+ * @param[in]  aTag    The subsystem.
+ * @param[in]  aCount  The number of elements.
+ * @param[in]  aSize   The size of each element.
+ *
+ * @returns A pointer to the memory, or NULL if the heap is exhausted.
+ *
+ */
+void *otrHeapCalloc(otrHeapTag aTag, size_t aCount, size_t aSize);
+
+/**
+ * This function resizes memory allocated by otrHeapMalloc(), keeping the subsystem it was charged to.
+ *
+ * @param[in]  aTag      The subsystem, used when @p aPointer is NULL.
+ * @param[in]  aPointer  The memory to resize, may be NULL.
+ * @param[in]  aSize     The new size in bytes.
+ *
+ * @returns A pointer to the memory, or NULL if the heap is exhausted and @p aPointer was left untouched.
+ *
+ */
+void *otrHeapRealloc(otrHeapTag aTag, void *aPointer, size_t aSize);
+
+/**
+ * This function frees memory allocated by any of the otrHeap functions.
+ *
+ * @param[in]  aPointer  The memory to free, may be NULL.
+ *
+ */
+void otrHeapFree(void *aPointer);
+
+/**
+ * This function gets the heap usage of a subsystem.
+ *
+ * @param[in]   aTag    The subsystem.
+ * @param[out]  aStats  Where the statistics are copied.
+ *
+ */
+void otrHeapGetStats(otrHeapTag aTag, otrHeapStats *aStats);
+
+/**
+ * This function resets the peaks and counters of every subsystem.
+ *
+ */
+void otrHeapResetStats(void);
+
+/**
+ * This function gets the name of a subsystem.
+ *
+ * @param[in]  aTag  The subsystem.
+ *
+ * @returns The name.
+ *
+ */
+const char *otrHeapTagName(otrHeapTag aTag);
+
+/**
+ * This function prints the heap usage of every subsystem to the standard output.
+ *
+ * It is called on every failed allocation, and by the FreeRTOS malloc failed hook.
+ *
+ */
+void otrHeapDump(void);
+
+/**
+ * This function allocates memory charged to OTR_HEAP_TAG_JSON, it is installed with json_set_alloc_funcs().
+ *
+ * The memory carries no header and may also be released with free(). libjwt v1.9.0 has no allocator hooks and frees
+ * the strings jansson returns with free(), those frees are not uncharged.
+ *
+ * @param[in]  aSize  The size in bytes.
+ *
+ * @returns A pointer to the memory, or NULL if the heap is exhausted.
+ *
+ */
+void *otrHeapJsonMalloc(size_t aSize);
+
+/**
+ * This function frees memory allocated by otrHeapJsonMalloc().
+ *
+ * @param[in]  aPointer  The memory to free, may be NULL.
+ *
+ */
+void otrHeapJsonFree(void *aPointer);
+
+/**
+ * This function allocates memory charged to OTR_HEAP_TAG_APP.
+ *
+ * Like otrHeapJsonMalloc(), the memory carries no header and may also be released with free(), so it can be handed to
+ * libraries that free it themselves.
+ *
+ * @param[in]  aSize  The size in bytes.
+ *
+ * @returns A pointer to the memory, or NULL if the heap is exhausted.
+ *
+ */
+void *otrHeapAppMalloc(size_t aSize);
+
+/**
+ * This function frees memory allocated by otrHeapAppMalloc().
+ *
+ * @param[in]  aPointer  The memory to free, may be NULL.
+ *
+ */
+void otrHeapAppFree(void *aPointer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OTR_HEAP_H_
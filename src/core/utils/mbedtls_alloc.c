@@ -0,0 +1,391 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mbedtls_alloc.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "heap.h"
+
+#define HEAP_CLASS 0xff
+
+struct otrMbedtlsBlock
+{
+    otrMbedtlsBlock *mNext;  // free list of the class, or the blocks of the arena
+    otrMbedtlsBlock *mPrev;  // the blocks of the arena
+    otrMbedtlsArena *mArena; // the arena charged, NULL if none
+    uint32_t         mSize;  // the bytes charged
+    uint8_t          mClass; // the size class, HEAP_CLASS for heap blocks
+} __attribute__((aligned(8)));
+
+struct Pool
+{
+    otrMbedtlsBlock *mFree;
+    uint16_t         mInUse;
+    uint16_t         mPeak;
+    uint32_t         mExhausted;
+};
+
+#define CLASS_CONFIG(aBlockSize, aNumBlocks) {aBlockSize, aNumBlocks},
+#define CLASS_BYTES(aBlockSize, aNumBlocks) +(aNumBlocks) * (sizeof(otrMbedtlsBlock) + (aBlockSize))
+
+static const struct
+{
+    uint16_t mBlockSize;
+    uint16_t mNumBlocks;
+} sClasses[OTR_MBEDTLS_POOL_NUM_CLASSES] = {OTR_CONFIG_MBEDTLS_POOL_CLASSES(CLASS_CONFIG)};
+
+static uint8_t sMemory[0 OTR_CONFIG_MBEDTLS_POOL_CLASSES(CLASS_BYTES)] __attribute__((aligned(8)));
+
+static struct Pool          sPools[OTR_MBEDTLS_POOL_NUM_CLASSES];
+static otrMbedtlsAllocStats sStats;
+
+void otrMbedtlsAllocInit(void)
+{
+    uint8_t *memory = sMemory;
+
+    for (uint8_t i = 0; i < OTR_MBEDTLS_POOL_NUM_CLASSES; i++)
+    {
+        sPools[i].mFree = NULL;
+
+        for (uint16_t j = 0; j < sClasses[i].mNumBlocks; j++)
+        {
+            otrMbedtlsBlock *block = (otrMbedtlsBlock *)memory;
+
+            block->mClass   = i;
+            block->mNext    = sPools[i].mFree;
+            sPools[i].mFree = block;
+            memory += sizeof(otrMbedtlsBlock) + sClasses[i].mBlockSize;
+        }
+    }
+}
+
+static otrMbedtlsArena *currentArena(void)
+{
+    otrMbedtlsArena *arena = NULL;
+
+    // mbedTLS may run before the scheduler starts, there is no task to hold an arena then.
+    if (xTaskGetCurrentTaskHandle() != NULL)
+    {
+        arena = pvTaskGetThreadLocalStoragePointer(NULL, OTR_CONFIG_MBEDTLS_ARENA_TLS_INDEX);
+    }
+
+    return arena;
+}
+
+static otrMbedtlsBlock *poolAlloc(size_t aSize)
+{
+    otrMbedtlsBlock *block = NULL;
+
+    for (uint8_t i = 0; i < OTR_MBEDTLS_POOL_NUM_CLASSES && block == NULL; i++)
+    {
+        struct Pool *pool = &sPools[i];
+
+        if (sClasses[i].mBlockSize < aSize)
+        {
+            continue;
+        }
+
+        if (pool->mFree == NULL)
+        {
+            pool->mExhausted++;
+            continue;
+        }
+
+        block        = pool->mFree;
+        pool->mFree  = block->mNext;
+        block->mSize = sClasses[i].mBlockSize;
+
+        if (++pool->mInUse > pool->mPeak)
+        {
+            pool->mPeak = pool->mInUse;
+        }
+    }
+
+    return block;
+}
+
+static void charge(otrMbedtlsBlock *aBlock, otrMbedtlsArena *aArena)
+{
+    aBlock->mArena = aArena;
+    aBlock->mPrev  = NULL;
+    aBlock->mNext  = NULL;
+
+    if (aArena != NULL)
+    {
+        aBlock->mNext = aArena->mBlocks;
+
+        if (aArena->mBlocks != NULL)
+        {
+            aArena->mBlocks->mPrev = aBlock;
+        }
+
+        aArena->mBlocks = aBlock;
+        aArena->mInUse += aBlock->mSize;
+
+        if (aArena->mInUse > aArena->mPeak)
+        {
+            aArena->mPeak = aArena->mInUse;
+        }
+    }
+}
+
+static void uncharge(otrMbedtlsBlock *aBlock)
+{
+    otrMbedtlsArena *arena = aBlock->mArena;
+
+    if (arena != NULL)
+    {
+        if (aBlock->mPrev != NULL)
+        {
+            aBlock->mPrev->mNext = aBlock->mNext;
+        }
+        else
+        {
+            arena->mBlocks = aBlock->mNext;
+        }
+
+        if (aBlock->mNext != NULL)
+        {
+            aBlock->mNext->mPrev = aBlock->mPrev;
+        }
+
+        arena->mInUse -= aBlock->mSize;
+        aBlock->mArena = NULL;
+    }
+}
+
+static otrMbedtlsBlock *heapAlloc(size_t aSize)
+{
+    otrMbedtlsBlock *block = NULL;
+
+    if (aSize <= UINT32_MAX - sizeof(otrMbedtlsBlock))
+    {
+        block = otrHeapMalloc(OTR_HEAP_TAG_MBEDTLS, sizeof(otrMbedtlsBlock) + aSize);
+    }
+
+    if (block != NULL)
+    {
+        block->mClass = HEAP_CLASS;
+        block->mSize  = (uint32_t)aSize;
+    }
+
+    return block;
+}
+
+void *otrMbedtlsCAlloc(size_t aCount, size_t aSize)
+{
+    size_t           size  = aCount * aSize;
+    otrMbedtlsBlock *block = NULL;
+
+    if (aSize == 0 || size / aSize == aCount)
+    {
+        taskENTER_CRITICAL();
+        block = poolAlloc(size);
+
+        if (block != NULL)
+        {
+            charge(block, currentArena());
+        }
+        taskEXIT_CRITICAL();
+
+        if (block == NULL && (block = heapAlloc(size)) != NULL)
+        {
+            taskENTER_CRITICAL();
+            charge(block, currentArena());
+            sStats.mHeapInUse += size;
+
+            if (sStats.mHeapInUse > sStats.mHeapPeak)
+            {
+                sStats.mHeapPeak = sStats.mHeapInUse;
+            }
+            taskEXIT_CRITICAL();
+        }
+    }
+
+    if (block == NULL)
+    {
+        taskENTER_CRITICAL();
+        sStats.mFailures++;
+        taskEXIT_CRITICAL();
+
+        return NULL;
+    }
+
+    memset(block + 1, 0, size);
+
+    return block + 1;
+}
+
+void otrMbedtlsFree(void *aPointer)
+{
+    otrMbedtlsBlock *block = (otrMbedtlsBlock *)aPointer - 1;
+    bool             heap;
+
+    if (aPointer == NULL)
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    uncharge(block);
+    heap = (block->mClass == HEAP_CLASS);
+
+    if (heap)
+    {
+        sStats.mHeapInUse -= block->mSize;
+    }
+    else
+    {
+        block->mNext                = sPools[block->mClass].mFree;
+        sPools[block->mClass].mFree = block;
+        sPools[block->mClass].mInUse--;
+    }
+    taskEXIT_CRITICAL();
+
+    if (heap)
+    {
+        otrHeapFree(block);
+    }
+}
+
+void otrMbedtlsArenaInit(otrMbedtlsArena *aArena)
+{
+    memset(aArena, 0, sizeof(*aArena));
+}
+
+static void setCurrentArena(otrMbedtlsArena *aArena)
+{
+    if (xTaskGetCurrentTaskHandle() != NULL)
+    {
+        vTaskSetThreadLocalStoragePointer(NULL, OTR_CONFIG_MBEDTLS_ARENA_TLS_INDEX, aArena);
+    }
+}
+
+otrMbedtlsArena *otrMbedtlsArenaEnter(otrMbedtlsArena *aArena)
+{
+    otrMbedtlsArena *previous = currentArena();
+
+    setCurrentArena(aArena);
+
+    return previous;
+}
+
+void otrMbedtlsArenaExit(otrMbedtlsArena *aPrevious)
+{
+    setCurrentArena(aPrevious);
+}
+
+void otrMbedtlsArenaHandshakeDone(otrMbedtlsArena *aArena)
+{
+    taskENTER_CRITICAL();
+    sStats.mHandshakes++;
+    sStats.mHandshakeLastPeak = aArena->mPeak;
+
+    if (aArena->mPeak > sStats.mHandshakeMaxPeak)
+    {
+        sStats.mHandshakeMaxPeak = aArena->mPeak;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void otrMbedtlsArenaRelease(otrMbedtlsArena *aArena)
+{
+    otrMbedtlsBlock *block;
+
+    taskENTER_CRITICAL();
+    sStats.mSessions++;
+    sStats.mSessionLastPeak = aArena->mPeak;
+
+    if (aArena->mPeak > sStats.mSessionMaxPeak)
+    {
+        sStats.mSessionMaxPeak = aArena->mPeak;
+    }
+
+    taskEXIT_CRITICAL();
+
+    if (currentArena() == aArena)
+    {
+        setCurrentArena(NULL);
+    }
+
+    // State outliving a connection, such as a saved session, is allocated outside of its arena. Whatever the
+    // connection's mbedTLS context did not free itself goes back in one sweep.
+    while ((block = aArena->mBlocks) != NULL)
+    {
+        taskENTER_CRITICAL();
+        uncharge(block);
+        sStats.mLeakedBlocks++;
+        taskEXIT_CRITICAL();
+
+        otrMbedtlsFree(block + 1);
+    }
+
+    otrMbedtlsArenaInit(aArena);
+}
+
+void otrMbedtlsAllocGetStats(otrMbedtlsAllocStats *aStats)
+{
+    taskENTER_CRITICAL();
+    *aStats = sStats;
+
+    for (uint8_t i = 0; i < OTR_MBEDTLS_POOL_NUM_CLASSES; i++)
+    {
+        aStats->mPools[i].mBlockSize = sClasses[i].mBlockSize;
+        aStats->mPools[i].mNumBlocks = sClasses[i].mNumBlocks;
+        aStats->mPools[i].mInUse     = sPools[i].mInUse;
+        aStats->mPools[i].mPeak      = sPools[i].mPeak;
+        aStats->mPools[i].mExhausted = sPools[i].mExhausted;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void otrMbedtlsAllocResetStats(void)
+{
+    taskENTER_CRITICAL();
+    for (uint8_t i = 0; i < OTR_MBEDTLS_POOL_NUM_CLASSES; i++)
+    {
+        sPools[i].mPeak      = sPools[i].mInUse;
+        sPools[i].mExhausted = 0;
+    }
+
+    sStats.mHeapPeak          = sStats.mHeapInUse;
+    sStats.mFailures          = 0;
+    sStats.mHandshakes        = 0;
+    sStats.mHandshakeLastPeak = 0;
+    sStats.mHandshakeMaxPeak  = 0;
+    sStats.mSessions          = 0;
+    sStats.mSessionLastPeak   = 0;
+    sStats.mSessionMaxPeak    = 0;
+    sStats.mLeakedBlocks      = 0;
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,187 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OTR_MBEDTLS_ALLOC_H_
+#define OTR_MBEDTLS_ALLOC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "otr_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OTR_MBEDTLS_POOL_COUNT_CLASS(aBlockSize, aNumBlocks) +1
+
+/**
+ * The number of size classes, see OTR_CONFIG_MBEDTLS_POOL_CLASSES.
+ *
+ */
+#define OTR_MBEDTLS_POOL_NUM_CLASSES (0 OTR_CONFIG_MBEDTLS_POOL_CLASSES(OTR_MBEDTLS_POOL_COUNT_CLASS))
+
+typedef struct otrMbedtlsBlock otrMbedtlsBlock;
+
+/**
+ * This structure represents the mbedTLS allocations of one TLS connection.
+ *
+ */
+typedef struct otrMbedtlsArena
+{
+    otrMbedtlsBlock *mBlocks; ///< The live allocations, released together by otrMbedtlsArenaRelease().
+    size_t           mInUse;  ///< Bytes currently allocated.
+    size_t           mPeak;   ///< The most bytes allocated at once.
+} otrMbedtlsArena;
+
+/**
+ * This structure represents the usage of one size class.
+ *
+ */
+typedef struct otrMbedtlsPoolStats
+{
+    uint16_t mBlockSize; ///< The block size in bytes.
+    uint16_t mNumBlocks; ///< The number of blocks.
+    uint16_t mInUse;     ///< Blocks currently allocated.
+    uint16_t mPeak;      ///< The most blocks allocated at once.
+    uint32_t mExhausted; ///< Requests that found the class empty and moved on.
+} otrMbedtlsPoolStats;
+
+/**
+ * This structure represents the statistics of the mbedTLS allocator.
+ *
+ */
+typedef struct otrMbedtlsAllocStats
+{
+    otrMbedtlsPoolStats mPools[OTR_MBEDTLS_POOL_NUM_CLASSES];
+    size_t              mHeapInUse;         ///< Bytes served by the heap.
+    size_t              mHeapPeak;          ///< The most bytes served by the heap at once.
+    uint32_t            mFailures;          ///< Requests that could not be served at all.
+    uint32_t            mHandshakes;        ///< Completed handshakes.
+    size_t              mHandshakeLastPeak; ///< Peak bytes of the last handshake.
+    size_t              mHandshakeMaxPeak;  ///< Peak bytes of the most expensive handshake.
+    uint32_t            mSessions;          ///< Released connection arenas.
+    size_t              mSessionLastPeak;   ///< Peak bytes of the last session.
+    size_t              mSessionMaxPeak;    ///< Peak bytes of the most expensive session.
+    uint32_t            mLeakedBlocks;      ///< Blocks still allocated, and then freed, when their arena was released.
+} otrMbedtlsAllocStats;
+
+/**
+ * This function initializes the pools, it must be called before the allocator is handed to mbedTLS.
+ *
+ */
+void otrMbedtlsAllocInit(void);
+
+/**
+ * This function allocates zeroed memory for mbedTLS.
+ *
+ * The request is served by the smallest size class with a free block, or by the heap. While the calling task is
+ * inside an arena, the block is charged to it.
+ *
+ * @param[in]  aCount  The number of elements.
+ * @param[in]  aSize   The size of each element.
+ *
+ * @returns A pointer to the memory, or NULL if none is left.
+ *
+ */
+void *otrMbedtlsCAlloc(size_t aCount, size_t aSize);
+
+/**
+ * This function frees memory allocated by otrMbedtlsCAlloc().
+ *
+ * @param[in]  aPointer  The memory to free, may be NULL.
+ *
+ */
+void otrMbedtlsFree(void *aPointer);
+
+/**
+ * This function initializes an empty arena.
+ *
+ * @param[in]  aArena  The arena.
+ *
+ */
+void otrMbedtlsArenaInit(otrMbedtlsArena *aArena);
+
+/**
+ * This function charges the following allocations of the calling task to an arena.
+ *
+ * The current arena is kept per task, in the thread local storage pointer OTR_CONFIG_MBEDTLS_ARENA_TLS_INDEX.
+ *
+ * @param[in]  aArena  The arena, or NULL to allocate outside of any arena.
+ *
+ * @returns The arena the task was in before, to be passed to otrMbedtlsArenaExit().
+ *
+ */
+otrMbedtlsArena *otrMbedtlsArenaEnter(otrMbedtlsArena *aArena);
+
+/**
+ * This function returns the calling task to the arena it was in before otrMbedtlsArenaEnter().
+ *
+ * @param[in]  aPrevious  The value returned by otrMbedtlsArenaEnter().
+ *
+ */
+void otrMbedtlsArenaExit(otrMbedtlsArena *aPrevious);
+
+/**
+ * This function records the peak usage of an arena as the cost of its handshake.
+ *
+ * @param[in]  aArena  The arena.
+ *
+ */
+void otrMbedtlsArenaHandshakeDone(otrMbedtlsArena *aArena);
+
+/**
+ * This function frees every block still charged to an arena and records its peak usage as a session.
+ *
+ * It is called once the connection's mbedTLS context is freed. State outliving the connection must be allocated
+ * outside of the arena, see otrMbedtlsArenaEnter().
+ *
+ * @param[in]  aArena  The arena.
+ *
+ */
+void otrMbedtlsArenaRelease(otrMbedtlsArena *aArena);
+
+/**
+ * This function gets the statistics of the mbedTLS allocator.
+ *
+ * @param[out]  aStats  Where the statistics are copied.
+ *
+ */
+void otrMbedtlsAllocGetStats(otrMbedtlsAllocStats *aStats);
+
+/**
+ * This function resets the peaks and counters of the mbedTLS allocator.
+ *
+ */
+void otrMbedtlsAllocResetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OTR_MBEDTLS_ALLOC_H_
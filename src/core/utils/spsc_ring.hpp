@@ -0,0 +1,131 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *   This file implements a bounded single-producer single-consumer ring.
+ */
+
+#ifndef OTR_SPSC_RING_HPP_
+#define OTR_SPSC_RING_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "otr_config.h"
+
+namespace ot {
+namespace Rtos {
+
+/**
+ * This class template implements a fixed-capacity single-producer single-consumer ring.
+ *
+ * The producer only writes the tail index and the consumer only writes the head index, so the two sides
+ * synchronize without a mutex. Zero-initialized storage is an empty ring, which allows instances with static
+ * storage duration to be used before any constructor has run.
+ *
+ * @tparam Type   The entry type, copied in and out of the ring.
+ * @tparam kSize  The capacity of the ring, must be a power of two.
+ *
+ */
+template <typename Type, uint16_t kSize> class SpscRing
+{
+    static_assert(kSize != 0 && (kSize & (kSize - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    /**
+     * This method appends an entry at the tail. It must only be called by the producer.
+     *
+     * @param[in]  aEntry  The entry to append.
+     *
+     * @retval true   The entry was appended.
+     * @retval false  The ring is full.
+     *
+     */
+    bool Push(const Type &aEntry)
+    {
+        uint32_t tail = __atomic_load_n(&mTail, __ATOMIC_RELAXED);
+        bool     rval = (tail - __atomic_load_n(&mHead, __ATOMIC_ACQUIRE) < kSize);
+
+        if (rval)
+        {
+            mEntries[tail & (kSize - 1)] = aEntry;
+            __atomic_store_n(&mTail, tail + 1, __ATOMIC_RELEASE);
+        }
+
+        return rval;
+    }
+
+    /**
+     * This method returns the entry at the head without removing it. It must only be called by the consumer.
+     *
+     * @returns A pointer to the head entry, or NULL if the ring is empty.
+     *
+     */
+    Type *Peek(void)
+    {
+        uint32_t head = __atomic_load_n(&mHead, __ATOMIC_RELAXED);
+
+        return (head == __atomic_load_n(&mTail, __ATOMIC_ACQUIRE)) ? NULL : &mEntries[head & (kSize - 1)];
+    }
+
+    /**
+     * This method removes the head entry. It must only be called by the consumer after a successful Peek().
+     *
+     */
+    void Pop(void) { __atomic_store_n(&mHead, __atomic_load_n(&mHead, __ATOMIC_RELAXED) + 1, __ATOMIC_RELEASE); }
+
+    /**
+     * This method returns the number of queued entries. It may be called from either side.
+     *
+     */
+    uint16_t GetLength(void) const
+    {
+        uint32_t head = __atomic_load_n(&mHead, __ATOMIC_ACQUIRE);
+
+        return static_cast<uint16_t>(__atomic_load_n(&mTail, __ATOMIC_ACQUIRE) - head);
+    }
+
+    /**
+     * This method returns the capacity of the ring.
+     *
+     */
+    static uint16_t GetSize(void) { return kSize; }
+
+private:
+    // The indexes run freely and are masked on access, head and tail live on separate cache lines so that
+    // the producer and consumer do not invalidate each other's line on every update.
+    alignas(OTR_CONFIG_CACHE_LINE_SIZE) uint32_t mHead;
+    alignas(OTR_CONFIG_CACHE_LINE_SIZE) uint32_t mTail;
+    Type mEntries[kSize];
+};
+
+} // namespace Rtos
+} // namespace ot
+
+#endif // OTR_SPSC_RING_HPP_
@@ -0,0 +1,164 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "virtual_time.h"
+
+#include "otr_config.h"
+
+#if PLATFORM_linux && OTR_CONFIG_VIRTUAL_TIME_ENABLE
+
+#include <stdbool.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include <task.h>
+
+// The wall clock starts at the real time of the first read, so certificates and tokens stay valid.
+static struct timespec sEpoch;
+static bool            sEpochValid  = false;
+static uint32_t        sLastTick    = 0;
+static uint64_t        sTickHigh    = 0;
+static uint32_t        sJumps       = 0;
+static uint64_t        sJumpedTicks = 0;
+
+int __real_clock_gettime(clockid_t aClockId, struct timespec *aTime);
+
+static uint64_t getTicks(void)
+{
+    uint32_t tick = (uint32_t)xTaskGetTickCount();
+
+    // Extend the 32 bit tick count, a long simulation covers more than 49 days.
+    if (tick < sLastTick)
+    {
+        sTickHigh += (uint64_t)1 << 32;
+    }
+
+    sLastTick = tick;
+
+    return sTickHigh | tick;
+}
+
+uint64_t virtualTimeNow(void)
+{
+    return getTicks() * portTICK_PERIOD_MS * 1000;
+}
+
+static void getWallClock(struct timespec *aTime)
+{
+    uint64_t now = virtualTimeNow();
+
+    if (!sEpochValid)
+    {
+        __real_clock_gettime(CLOCK_REALTIME, &sEpoch);
+        sEpochValid = true;
+    }
+
+    aTime->tv_sec  = sEpoch.tv_sec + (time_t)(now / 1000000);
+    aTime->tv_nsec = sEpoch.tv_nsec + (long)(now % 1000000) * 1000;
+
+    if (aTime->tv_nsec >= 1000000000)
+    {
+        aTime->tv_sec++;
+        aTime->tv_nsec -= 1000000000;
+    }
+}
+
+int __wrap_clock_gettime(clockid_t aClockId, struct timespec *aTime)
+{
+    int      rval = 0;
+    uint64_t now;
+
+    switch (aClockId)
+    {
+    case CLOCK_REALTIME:
+        getWallClock(aTime);
+        break;
+
+    case CLOCK_MONOTONIC:
+    case CLOCK_MONOTONIC_RAW:
+    case CLOCK_BOOTTIME:
+        now            = virtualTimeNow();
+        aTime->tv_sec  = (time_t)(now / 1000000);
+        aTime->tv_nsec = (long)(now % 1000000) * 1000;
+        break;
+
+    default:
+        // CPU time clocks keep measuring the real work done.
+        rval = __real_clock_gettime(aClockId, aTime);
+        break;
+    }
+
+    return rval;
+}
+
+int __wrap_gettimeofday(struct timeval *aTime, void *aTimeZone)
+{
+    struct timespec now;
+
+    (void)aTimeZone;
+
+    getWallClock(&now);
+    aTime->tv_sec  = now.tv_sec;
+    aTime->tv_usec = now.tv_nsec / 1000;
+
+    return 0;
+}
+
+time_t __wrap_time(time_t *aTime)
+{
+    struct timespec now;
+
+    getWallClock(&now);
+
+    if (aTime != NULL)
+    {
+        *aTime = now.tv_sec;
+    }
+
+    return now.tv_sec;
+}
+
+void virtualTimeSuppressTicksAndSleep(TickType_t aExpectedIdleTime)
+{
+    // Called by the idle task with the scheduler suspended, nothing can run until the ticks are stepped.
+    if (eTaskConfirmSleepModeStatus() != eAbortSleep)
+    {
+        vTaskStepTick(aExpectedIdleTime);
+        sJumps++;
+        sJumpedTicks += aExpectedIdleTime;
+    }
+}
+
+void virtualTimeGetStats(otrVirtualTimeStats *aStats)
+{
+    aStats->mJumps     = sJumps;
+    aStats->mJumpedMs  = sJumpedTicks * portTICK_PERIOD_MS;
+    aStats->mElapsedMs = virtualTimeNow() / 1000;
+}
+
+#endif // PLATFORM_linux && OTR_CONFIG_VIRTUAL_TIME_ENABLE
@@ -0,0 +1,84 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef OTR_VIRTUAL_TIME_H_
+#define OTR_VIRTUAL_TIME_H_
+
+#include <stdint.h>
+
+#include <FreeRTOS.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * This structure represents the statistics of the simulated clock.
+ *
+ */
+typedef struct otrVirtualTimeStats
+{
+    uint32_t mJumps;     ///< Times the clock skipped ahead because every task was blocked.
+    uint64_t mJumpedMs;  ///< The simulated time skipped in total, in milliseconds.
+    uint64_t mElapsedMs; ///< The simulated time since start, in milliseconds.
+} otrVirtualTimeStats;
+
+/**
+ * This function returns the simulated time since start, in microseconds.
+ *
+ * The simulated clock is the FreeRTOS tick count. OpenThread alarms, lwIP `sys_now()` and the applications all read
+ * it, the first through `clock_gettime()` and `gettimeofday()` which are wrapped at link time.
+ *
+ */
+uint64_t virtualTimeNow(void);
+
+/**
+ * This function skips the simulated clock to the next FreeRTOS deadline.
+ *
+ * The Linux FreeRTOSConfig.h sets `configUSE_TICKLESS_IDLE` and maps `portSUPPRESS_TICKS_AND_SLEEP()` to this
+ * function, so that time jumps whenever all tasks are blocked. Runs are only replayed exactly when the port tick
+ * timer is not started, time then moves solely through these jumps.
+ *
+ * @param[in]  aExpectedIdleTime  The ticks until the next task unblocks, as computed by the FreeRTOS kernel.
+ *
+ */
+void virtualTimeSuppressTicksAndSleep(TickType_t aExpectedIdleTime);
+
+/**
+ * This function gets the statistics of the simulated clock.
+ *
+ * @param[out]  aStats  Where the statistics are copied.
+ *
+ */
+void virtualTimeGetStats(otrVirtualTimeStats *aStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OTR_VIRTUAL_TIME_H_
@@ -0,0 +1,612 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "net/utils/dns_resolver.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "lwip/def.h"
+#include "lwip/dns.h"
+#include "lwip/pbuf.h"
+#include "lwip/sys.h"
+#include "lwip/timeouts.h"
+#include "lwip/udp.h"
+
+#include "net/utils/nat64_utils.h"
+#include "otr_config.h"
+
+#define DNS_SERVER_PORT 53
+#define DNS_HEADER_SIZE 12
+#define DNS_MAX_MESSAGE_SIZE 512
+#define DNS_FLAG_RESPONSE 0x8000
+#define DNS_FLAG_RECURSION_DESIRED 0x0100
+#define DNS_RCODE_MASK 0x000f
+#define DNS_RCODE_NOERROR 0
+#define DNS_RCODE_NXDOMAIN 3
+#define DNS_TYPE_A 1
+#define DNS_CLASS_IN 1
+
+typedef enum
+{
+    kEntryFree,      ///< The entry is unused.
+    kEntryResolving, ///< The first query for the name is in flight.
+    kEntryValid,     ///< The entry holds an address.
+    kEntryNegative,  ///< The name does not exist or has no A record.
+} EntryState;
+
+typedef struct DnsEntry
+{
+    char       mName[OTR_CONFIG_DNS_MAX_NAME_LENGTH + 1];
+    ip4_addr_t mAddresses[OTR_CONFIG_DNS_MAX_ADDRESSES];
+    uint8_t    mNumAddresses;
+    uint32_t   mExpireTime; ///< sys_now() value the answer expires at.
+    uint32_t   mTtl;        ///< The TTL of the answer, in milliseconds.
+    uint32_t   mSentTime;   ///< sys_now() value the last query was sent at.
+    uint16_t   mMessageId;
+    uint8_t    mState;
+    uint8_t    mRetries;
+    uint8_t    mServer;
+    bool       mQuerying; ///< A query is in flight, also set while a valid entry is refreshed.
+} DnsEntry;
+
+typedef struct DnsWaiter
+{
+    DnsEntry *            mEntry;
+    dnsResolveCallback    mCallback;    ///< Set for dnsResolve(), wants the first address only.
+    dnsResolveAllCallback mAllCallback; ///< Set for dnsResolveAll().
+    void *                mContext;
+} DnsWaiter;
+
+static DnsEntry        sEntries[OTR_CONFIG_DNS_CACHE_SIZE];
+static DnsWaiter       sWaiters[OTR_CONFIG_DNS_MAX_WAITERS];
+static struct udp_pcb *sPcb;
+static bool            sTimerRunning;
+
+static void handleRetryTimer(void *aArg);
+
+static bool isExpired(const DnsEntry *aEntry, uint32_t aNow)
+{
+    return (int32_t)(aNow - aEntry->mExpireTime) >= 0;
+}
+
+static DnsEntry *findEntry(const char *aHostName)
+{
+    DnsEntry *entry = NULL;
+
+    for (size_t i = 0; i < LWIP_ARRAYSIZE(sEntries); i++)
+    {
+        if (sEntries[i].mState != kEntryFree && lwip_stricmp(sEntries[i].mName, aHostName) == 0)
+        {
+            entry = &sEntries[i];
+            break;
+        }
+    }
+
+    return entry;
+}
+
+static DnsEntry *allocEntry(uint32_t aNow)
+{
+    DnsEntry *entry = NULL;
+
+    for (size_t i = 0; i < LWIP_ARRAYSIZE(sEntries); i++)
+    {
+        DnsEntry *candidate = &sEntries[i];
+
+        if (candidate->mState == kEntryFree)
+        {
+            entry = candidate;
+            break;
+        }
+
+        // Otherwise evict the answer that expires first, never one with a query in flight.
+        if (!candidate->mQuerying && (entry == NULL || isExpired(candidate, aNow) ||
+                                      (int32_t)(candidate->mExpireTime - entry->mExpireTime) < 0))
+        {
+            entry = candidate;
+        }
+    }
+
+    return entry;
+}
+
+static DnsWaiter *allocWaiter(void)
+{
+    DnsWaiter *waiter = NULL;
+
+    for (size_t i = 0; i < LWIP_ARRAYSIZE(sWaiters); i++)
+    {
+        if (sWaiters[i].mEntry == NULL)
+        {
+            waiter = &sWaiters[i];
+            break;
+        }
+    }
+
+    return waiter;
+}
+
+static uint8_t getAddresses(const DnsEntry *aEntry, ip6_addr_t *aAddresses, uint8_t aMaxAddresses)
+{
+    uint8_t count = 0;
+
+    if (aEntry->mState == kEntryValid)
+    {
+        count = LWIP_MIN(aEntry->mNumAddresses, aMaxAddresses);
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            aAddresses[i] = getNat64Address(&aEntry->mAddresses[i]);
+        }
+    }
+
+    return count;
+}
+
+static void notifyWaiters(DnsEntry *aEntry)
+{
+    ip6_addr_t addresses[OTR_CONFIG_DNS_MAX_ADDRESSES];
+    uint8_t    count = getAddresses(aEntry, addresses, OTR_CONFIG_DNS_MAX_ADDRESSES);
+
+    for (size_t i = 0; i < LWIP_ARRAYSIZE(sWaiters); i++)
+    {
+        DnsWaiter waiter = sWaiters[i];
+
+        if (waiter.mEntry != aEntry)
+        {
+            continue;
+        }
+
+        // Released first, the callback may start another lookup.
+        sWaiters[i].mEntry = NULL;
+
+        if (waiter.mAllCallback != NULL)
+        {
+            waiter.mAllCallback(aEntry->mName, addresses, count, waiter.mContext);
+        }
+        else
+        {
+            waiter.mCallback(aEntry->mName, (count > 0) ? &addresses[0] : NULL, waiter.mContext);
+        }
+    }
+}
+
+static const ip_addr_t *getServer(uint8_t aIndex)
+{
+    const ip_addr_t *server = NULL;
+
+    if (aIndex < DNS_MAX_SERVERS)
+    {
+        server = dns_getserver(aIndex);
+
+        if (ip_addr_isany(server))
+        {
+            server = NULL;
+        }
+    }
+
+    return server;
+}
+
+static err_t sendQuery(DnsEntry *aEntry)
+{
+    err_t            err    = ERR_OK;
+    const ip_addr_t *server = getServer(aEntry->mServer);
+    size_t           length = strlen(aEntry->mName);
+    struct pbuf *    buffer = NULL;
+    uint8_t *        cursor;
+    const char *     label;
+
+    // No server before the first attach.
+    if (server == NULL)
+    {
+        return ERR_RTE;
+    }
+
+    // Header, the name as labels plus the root label, and the type and class.
+    buffer = pbuf_alloc(PBUF_TRANSPORT, (u16_t)(DNS_HEADER_SIZE + length + 2 + 4), PBUF_RAM);
+    if (buffer == NULL)
+    {
+        return ERR_MEM;
+    }
+
+    cursor = (uint8_t *)buffer->payload;
+    memset(cursor, 0, DNS_HEADER_SIZE);
+    cursor[0] = (uint8_t)(aEntry->mMessageId >> 8);
+    cursor[1] = (uint8_t)(aEntry->mMessageId & 0xff);
+    cursor[2] = DNS_FLAG_RECURSION_DESIRED >> 8;
+    cursor[5] = 1; // QDCOUNT
+    cursor += DNS_HEADER_SIZE;
+
+    label = aEntry->mName;
+    while (*label != '\0')
+    {
+        const char *end = strchr(label, '.');
+        size_t      labelLength;
+
+        if (end == NULL)
+        {
+            end = label + strlen(label);
+        }
+
+        labelLength = (size_t)(end - label);
+        *cursor++   = (uint8_t)labelLength;
+        memcpy(cursor, label, labelLength);
+        cursor += labelLength;
+        label = (*end == '.') ? end + 1 : end;
+    }
+
+    *cursor++ = 0;
+    *cursor++ = 0;
+    *cursor++ = DNS_TYPE_A;
+    *cursor++ = 0;
+    *cursor++ = DNS_CLASS_IN;
+
+    // A name ending in a dot has one label less than counted above.
+    pbuf_realloc(buffer, (u16_t)(cursor - (uint8_t *)buffer->payload));
+
+    err                = udp_sendto(sPcb, buffer, server, DNS_SERVER_PORT);
+    aEntry->mSentTime  = sys_now();
+    pbuf_free(buffer);
+
+    if (!sTimerRunning)
+    {
+        sTimerRunning = true;
+        sys_timeout(OTR_CONFIG_DNS_RETRY_INTERVAL, handleRetryTimer, NULL);
+    }
+
+    return err;
+}
+
+static err_t startQuery(DnsEntry *aEntry)
+{
+    aEntry->mMessageId = (uint16_t)LWIP_RAND();
+    aEntry->mRetries   = 0;
+    aEntry->mServer    = 0;
+    aEntry->mQuerying  = true;
+
+    return sendQuery(aEntry);
+}
+
+static void failQuery(DnsEntry *aEntry)
+{
+    aEntry->mQuerying = false;
+
+    // A failed refresh keeps the old answer until it expires.
+    if (aEntry->mState == kEntryResolving || isExpired(aEntry, sys_now()))
+    {
+        aEntry->mState = kEntryFree;
+        notifyWaiters(aEntry);
+    }
+}
+
+static void handleRetryTimer(void *aArg)
+{
+    uint32_t now = sys_now();
+
+    LWIP_UNUSED_ARG(aArg);
+    sTimerRunning = false;
+
+    for (size_t i = 0; i < LWIP_ARRAYSIZE(sEntries); i++)
+    {
+        DnsEntry *entry = &sEntries[i];
+
+        if (!entry->mQuerying || now - entry->mSentTime < OTR_CONFIG_DNS_RETRY_INTERVAL)
+        {
+            continue;
+        }
+
+        if (++entry->mRetries >= OTR_CONFIG_DNS_MAX_RETRIES)
+        {
+            entry->mRetries = 0;
+            entry->mServer++;
+        }
+
+        if (getServer(entry->mServer) == NULL || sendQuery(entry) != ERR_OK)
+        {
+            failQuery(entry);
+        }
+    }
+
+    for (size_t i = 0; i < LWIP_ARRAYSIZE(sEntries); i++)
+    {
+        if (sEntries[i].mQuerying && !sTimerRunning)
+        {
+            sTimerRunning = true;
+            sys_timeout(OTR_CONFIG_DNS_RETRY_INTERVAL, handleRetryTimer, NULL);
+        }
+    }
+}
+
+static uint16_t readUint16(const uint8_t *aBuffer)
+{
+    return (uint16_t)((aBuffer[0] << 8) | aBuffer[1]);
+}
+
+static uint32_t readUint32(const uint8_t *aBuffer)
+{
+    return ((uint32_t)readUint16(aBuffer) << 16) | readUint16(aBuffer + 2);
+}
+
+static size_t skipName(const uint8_t *aMessage, size_t aLength, size_t aOffset)
+{
+    while (aOffset < aLength)
+    {
+        uint8_t labelLength = aMessage[aOffset];
+
+        if (labelLength == 0)
+        {
+            return aOffset + 1;
+        }
+
+        if ((labelLength & 0xc0) == 0xc0)
+        {
+            // A compression pointer ends the name.
+            return aOffset + 2;
+        }
+
+        aOffset += 1 + labelLength;
+    }
+
+    return aLength + 1;
+}
+
+static void handleResponse(void *aArg, struct udp_pcb *aPcb, struct pbuf *aBuffer, const ip_addr_t *aAddress,
+                           u16_t aPort)
+{
+    uint8_t   message[DNS_MAX_MESSAGE_SIZE];
+    size_t    length = pbuf_copy_partial(aBuffer, message, sizeof(message), 0);
+    DnsEntry *entry  = NULL;
+    uint16_t  flags;
+    uint16_t  answerCount;
+    size_t    offset;
+    uint32_t  ttl = OTR_CONFIG_DNS_NEGATIVE_TTL;
+    uint32_t  now = sys_now();
+
+    LWIP_UNUSED_ARG(aArg);
+    LWIP_UNUSED_ARG(aPcb);
+    LWIP_UNUSED_ARG(aPort);
+
+    pbuf_free(aBuffer);
+
+    if (length < DNS_HEADER_SIZE)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < LWIP_ARRAYSIZE(sEntries); i++)
+    {
+        const ip_addr_t *server = getServer(sEntries[i].mServer);
+
+        if (sEntries[i].mQuerying && sEntries[i].mMessageId == readUint16(message) && server != NULL &&
+            ip_addr_cmp(aAddress, server))
+        {
+            entry = &sEntries[i];
+            break;
+        }
+    }
+
+    flags = readUint16(message + 2);
+    if (entry == NULL || (flags & DNS_FLAG_RESPONSE) == 0)
+    {
+        return;
+    }
+
+    answerCount = readUint16(message + 6);
+    offset      = skipName(message, length, DNS_HEADER_SIZE) + 4;
+
+    if ((flags & DNS_RCODE_MASK) == DNS_RCODE_NOERROR)
+    {
+        entry->mState        = kEntryNegative;
+        entry->mNumAddresses = 0;
+
+        // Collect the A records, CNAME records in between are skipped. The shortest TTL applies to all.
+        for (uint16_t i = 0; i < answerCount && entry->mNumAddresses < OTR_CONFIG_DNS_MAX_ADDRESSES; i++)
+        {
+            uint16_t dataLength;
+
+            offset = skipName(message, length, offset);
+            if (offset + 10 > length)
+            {
+                break;
+            }
+
+            dataLength = readUint16(message + offset + 8);
+            if (offset + 10 + dataLength > length)
+            {
+                break;
+            }
+
+            if (readUint16(message + offset) == DNS_TYPE_A && readUint16(message + offset + 2) == DNS_CLASS_IN &&
+                dataLength == sizeof(entry->mAddresses[0].addr))
+            {
+                uint32_t recordTtl = LWIP_MIN(readUint32(message + offset + 4), OTR_CONFIG_DNS_MAX_TTL);
+
+                ttl = (entry->mState == kEntryValid) ? LWIP_MIN(ttl, recordTtl) : recordTtl;
+                memcpy(&entry->mAddresses[entry->mNumAddresses++].addr, message + offset + 10, dataLength);
+                entry->mState = kEntryValid;
+            }
+
+            offset += 10 + dataLength;
+        }
+    }
+    else if ((flags & DNS_RCODE_MASK) == DNS_RCODE_NXDOMAIN)
+    {
+        entry->mState = kEntryNegative;
+    }
+    else
+    {
+        // Server failure or refusal, let the retry timer move on to the next server.
+        entry->mSentTime = now - OTR_CONFIG_DNS_RETRY_INTERVAL;
+        entry->mRetries  = OTR_CONFIG_DNS_MAX_RETRIES;
+        return;
+    }
+
+    entry->mQuerying   = false;
+    entry->mTtl        = ttl * 1000;
+    entry->mExpireTime = now + entry->mTtl;
+    notifyWaiters(entry);
+}
+
+static err_t lookup(const char *aHostName, DnsEntry **aEntry)
+{
+    uint32_t  now = sys_now();
+    DnsEntry *entry;
+
+    LWIP_ASSERT_CORE_LOCKED();
+
+    if (strlen(aHostName) > OTR_CONFIG_DNS_MAX_NAME_LENGTH)
+    {
+        return ERR_ARG;
+    }
+
+    entry = findEntry(aHostName);
+
+    if (entry != NULL && entry->mState != kEntryResolving && isExpired(entry, now))
+    {
+        if (entry->mQuerying)
+        {
+            // Expired while being refreshed, wait for the new answer.
+            entry->mState = kEntryResolving;
+        }
+        else
+        {
+            entry->mState = kEntryFree;
+            entry         = NULL;
+        }
+    }
+
+    *aEntry = entry;
+
+    if (entry != NULL && entry->mState == kEntryValid)
+    {
+#if OTR_CONFIG_DNS_PREFETCH_ENABLE
+        // Refresh in the background once less than an eighth of the TTL is left.
+        if (!entry->mQuerying && entry->mExpireTime - now < entry->mTtl / 8 && startQuery(entry) != ERR_OK)
+        {
+            entry->mQuerying = false;
+        }
+#endif
+        return ERR_OK;
+    }
+
+    if (entry != NULL)
+    {
+        return (entry->mState == kEntryNegative) ? ERR_VAL : ERR_INPROGRESS;
+    }
+
+    if (sPcb == NULL)
+    {
+        sPcb = udp_new_ip_type(IPADDR_TYPE_ANY);
+        if (sPcb == NULL)
+        {
+            return ERR_MEM;
+        }
+
+        udp_bind(sPcb, IP_ANY_TYPE, 0);
+        udp_recv(sPcb, handleResponse, NULL);
+    }
+
+    entry = allocEntry(now);
+    if (entry == NULL)
+    {
+        return ERR_MEM;
+    }
+
+    strcpy(entry->mName, aHostName);
+    entry->mState = kEntryResolving;
+
+    if (startQuery(entry) != ERR_OK)
+    {
+        entry->mState    = kEntryFree;
+        entry->mQuerying = false;
+        return ERR_MEM;
+    }
+
+    *aEntry = entry;
+
+    return ERR_INPROGRESS;
+}
+
+static err_t addWaiter(DnsEntry *aEntry, dnsResolveCallback aCallback, dnsResolveAllCallback aAllCallback,
+                       void *aContext)
+{
+    DnsWaiter *waiter = allocWaiter();
+
+    // Without a waiter the query still completes and fills the cache.
+    if (waiter == NULL)
+    {
+        return ERR_MEM;
+    }
+
+    waiter->mEntry       = aEntry;
+    waiter->mCallback    = aCallback;
+    waiter->mAllCallback = aAllCallback;
+    waiter->mContext     = aContext;
+
+    return ERR_INPROGRESS;
+}
+
+err_t dnsResolve(const char *aHostName, ip6_addr_t *aAddress, dnsResolveCallback aCallback, void *aContext)
+{
+    DnsEntry *entry;
+    err_t     err = lookup(aHostName, &entry);
+
+    if (err == ERR_OK)
+    {
+        getAddresses(entry, aAddress, 1);
+    }
+    else if (err == ERR_INPROGRESS)
+    {
+        err = addWaiter(entry, aCallback, NULL, aContext);
+    }
+
+    return err;
+}
+
+err_t dnsResolveAll(const char *          aHostName,
+                    ip6_addr_t *          aAddresses,
+                    uint8_t *             aNumAddresses,
+                    dnsResolveAllCallback aCallback,
+                    void *                aContext)
+{
+    DnsEntry *entry;
+    err_t     err = lookup(aHostName, &entry);
+
+    if (err == ERR_OK)
+    {
+        *aNumAddresses = getAddresses(entry, aAddresses, *aNumAddresses);
+    }
+    else if (err == ERR_INPROGRESS)
+    {
+        err = addWaiter(entry, NULL, aCallback, aContext);
+    }
+
+    return err;
+}
@@ -0,0 +1,375 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "net/utils/nat64_connect.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "lwip/sys.h"
+#include "lwip/timeouts.h"
+
+#include "net/utils/dns_resolver.h"
+#include "otr_config.h"
+
+// Addresses never tried sort after the ones known to work and before the ones known to fail.
+#define RTT_UNKNOWN 10000
+#define RTT_FAILED 60000
+
+struct Nat64Connection;
+
+typedef struct ConnectAttempt
+{
+    struct Nat64Connection *mConnection;
+    struct altcp_pcb *      mPcb;
+    ip6_addr_t              mAddress;
+    uint32_t                mStartTime;
+} ConnectAttempt;
+
+typedef struct Nat64Connection
+{
+    bool                 mInUse;
+    bool                 mHasAllocator;
+    altcp_allocator_t    mAllocator;
+    uint16_t             mPort;
+    nat64ConnectCallback mCallback;
+    void *               mContext;
+    ConnectAttempt       mAttempts[OTR_CONFIG_DNS_MAX_ADDRESSES];
+    uint8_t              mNumAttempts;
+    uint8_t              mNextAttempt;
+} Nat64Connection;
+
+typedef struct RttEntry
+{
+    ip6_addr_t mAddress;
+    uint32_t   mRtt; ///< Smoothed connect time in milliseconds, 0 if the entry is unused.
+    uint32_t   mLastUpdate;
+} RttEntry;
+
+static Nat64Connection sConnections[OTR_CONFIG_NAT64_MAX_CONNECTIONS];
+static RttEntry        sRttTable[OTR_CONFIG_NAT64_RTT_TABLE_SIZE];
+
+static void handleStaggerTimer(void *aArg);
+static void handleAttemptError(void *aArg, err_t aError);
+
+static RttEntry *findRtt(const ip6_addr_t *aAddress)
+{
+    RttEntry *entry = NULL;
+
+    for (size_t i = 0; i < LWIP_ARRAYSIZE(sRttTable); i++)
+    {
+        if (sRttTable[i].mRtt != 0 && ip6_addr_cmp_zoneless(&sRttTable[i].mAddress, aAddress))
+        {
+            entry = &sRttTable[i];
+            break;
+        }
+    }
+
+    return entry;
+}
+
+static uint32_t getRtt(const ip6_addr_t *aAddress)
+{
+    RttEntry *entry = findRtt(aAddress);
+
+    return (entry != NULL) ? entry->mRtt : RTT_UNKNOWN;
+}
+
+static void updateRtt(const ip6_addr_t *aAddress, uint32_t aRtt)
+{
+    RttEntry *entry = findRtt(aAddress);
+
+    if (entry == NULL)
+    {
+        // Replace the entry updated longest ago.
+        entry = &sRttTable[0];
+
+        for (size_t i = 0; i < LWIP_ARRAYSIZE(sRttTable); i++)
+        {
+            if (sRttTable[i].mRtt == 0)
+            {
+                entry = &sRttTable[i];
+                break;
+            }
+
+            if ((int32_t)(sRttTable[i].mLastUpdate - entry->mLastUpdate) < 0)
+            {
+                entry = &sRttTable[i];
+            }
+        }
+
+        ip6_addr_copy(entry->mAddress, *aAddress);
+        entry->mRtt = aRtt;
+    }
+    else if (aRtt == RTT_FAILED)
+    {
+        entry->mRtt = aRtt;
+    }
+    else
+    {
+        // Same smoothing as the TCP round trip estimate, a single success clears an earlier failure.
+        entry->mRtt = (entry->mRtt >= RTT_UNKNOWN) ? aRtt : (7 * entry->mRtt + aRtt) / 8;
+    }
+
+    if (entry->mRtt == 0)
+    {
+        entry->mRtt = 1;
+    }
+
+    entry->mLastUpdate = sys_now();
+}
+
+static void finish(Nat64Connection *aConnection, struct altcp_pcb *aPcb, err_t aError)
+{
+    nat64ConnectCallback callback = aConnection->mCallback;
+    void *               context  = aConnection->mContext;
+
+    sys_untimeout(handleStaggerTimer, aConnection);
+
+    for (uint8_t i = 0; i < aConnection->mNumAttempts; i++)
+    {
+        struct altcp_pcb *pcb = aConnection->mAttempts[i].mPcb;
+
+        if (pcb == NULL)
+        {
+            continue;
+        }
+
+        altcp_arg(pcb, NULL);
+        altcp_err(pcb, NULL);
+
+        if (pcb != aPcb)
+        {
+            altcp_abort(pcb);
+        }
+    }
+
+    aConnection->mInUse = false;
+    callback(aPcb, aError, context);
+}
+
+static bool hasPendingAttempt(const Nat64Connection *aConnection)
+{
+    bool pending = false;
+
+    for (uint8_t i = 0; i < aConnection->mNumAttempts; i++)
+    {
+        if (aConnection->mAttempts[i].mPcb != NULL)
+        {
+            pending = true;
+            break;
+        }
+    }
+
+    return pending;
+}
+
+static err_t handleAttemptConnected(void *aArg, struct altcp_pcb *aPcb, err_t aError)
+{
+    ConnectAttempt *attempt = (ConnectAttempt *)aArg;
+
+    LWIP_UNUSED_ARG(aError);
+
+    updateRtt(&attempt->mAddress, sys_now() - attempt->mStartTime);
+    finish(attempt->mConnection, aPcb, ERR_OK);
+
+    return ERR_OK;
+}
+
+static err_t startNextAttempt(Nat64Connection *aConnection)
+{
+    err_t err = ERR_CONN;
+
+    while (err != ERR_OK && aConnection->mNextAttempt < aConnection->mNumAttempts)
+    {
+        ConnectAttempt *attempt = &aConnection->mAttempts[aConnection->mNextAttempt++];
+        ip_addr_t       address;
+
+        attempt->mPcb = altcp_new_ip_type(aConnection->mHasAllocator ? &aConnection->mAllocator : NULL,
+                                          IPADDR_TYPE_V6);
+        if (attempt->mPcb == NULL)
+        {
+            err = ERR_MEM;
+            break;
+        }
+
+        ip_addr_copy_from_ip6(address, attempt->mAddress);
+        altcp_arg(attempt->mPcb, attempt);
+        altcp_err(attempt->mPcb, handleAttemptError);
+        attempt->mStartTime = sys_now();
+
+        err = altcp_connect(attempt->mPcb, &address, aConnection->mPort, handleAttemptConnected);
+        if (err != ERR_OK)
+        {
+            altcp_arg(attempt->mPcb, NULL);
+            altcp_err(attempt->mPcb, NULL);
+            altcp_abort(attempt->mPcb);
+            attempt->mPcb = NULL;
+            updateRtt(&attempt->mAddress, RTT_FAILED);
+        }
+    }
+
+    if (err == ERR_OK && aConnection->mNextAttempt < aConnection->mNumAttempts)
+    {
+        sys_timeout(OTR_CONFIG_NAT64_CONNECT_DELAY, handleStaggerTimer, aConnection);
+    }
+
+    return err;
+}
+
+static void handleAttemptError(void *aArg, err_t aError)
+{
+    ConnectAttempt * attempt    = (ConnectAttempt *)aArg;
+    Nat64Connection *connection = attempt->mConnection;
+
+    // The pcb has already been freed by lwIP.
+    attempt->mPcb = NULL;
+    updateRtt(&attempt->mAddress, RTT_FAILED);
+
+    if (!hasPendingAttempt(connection))
+    {
+        // Nothing left in flight, move on to the next address without waiting for the timer.
+        sys_untimeout(handleStaggerTimer, connection);
+
+        if (startNextAttempt(connection) != ERR_OK)
+        {
+            finish(connection, NULL, aError);
+        }
+    }
+}
+
+static void handleStaggerTimer(void *aArg)
+{
+    Nat64Connection *connection = (Nat64Connection *)aArg;
+
+    if (startNextAttempt(connection) != ERR_OK && !hasPendingAttempt(connection))
+    {
+        finish(connection, NULL, ERR_CONN);
+    }
+}
+
+static void setAddresses(Nat64Connection *aConnection, const ip6_addr_t *aAddresses, uint8_t aNumAddresses)
+{
+    aConnection->mNumAttempts = 0;
+    aConnection->mNextAttempt = 0;
+
+    // Insertion sort by the remembered connect time, stable so that unknown addresses keep the DNS order.
+    for (uint8_t i = 0; i < aNumAddresses; i++)
+    {
+        uint32_t rtt   = getRtt(&aAddresses[i]);
+        uint8_t  index = aConnection->mNumAttempts;
+
+        while (index > 0 && getRtt(&aConnection->mAttempts[index - 1].mAddress) > rtt)
+        {
+            aConnection->mAttempts[index] = aConnection->mAttempts[index - 1];
+            index--;
+        }
+
+        memset(&aConnection->mAttempts[index], 0, sizeof(aConnection->mAttempts[index]));
+        aConnection->mAttempts[index].mConnection = aConnection;
+        ip6_addr_copy(aConnection->mAttempts[index].mAddress, aAddresses[i]);
+        aConnection->mNumAttempts++;
+    }
+}
+
+static void handleResolved(const char *aHostName, const ip6_addr_t *aAddresses, uint8_t aNumAddresses, void *aContext)
+{
+    Nat64Connection *connection = (Nat64Connection *)aContext;
+
+    LWIP_UNUSED_ARG(aHostName);
+
+    setAddresses(connection, aAddresses, aNumAddresses);
+
+    if (aNumAddresses == 0)
+    {
+        finish(connection, NULL, ERR_VAL);
+    }
+    else if (startNextAttempt(connection) != ERR_OK)
+    {
+        finish(connection, NULL, ERR_CONN);
+    }
+}
+
+err_t nat64Connect(const char *         aHostName,
+                   uint16_t             aPort,
+                   altcp_allocator_t *  aAllocator,
+                   nat64ConnectCallback aCallback,
+                   void *               aContext)
+{
+    Nat64Connection *connection = NULL;
+    ip6_addr_t       addresses[OTR_CONFIG_DNS_MAX_ADDRESSES];
+    uint8_t          numAddresses = OTR_CONFIG_DNS_MAX_ADDRESSES;
+    err_t            err;
+
+    LWIP_ASSERT_CORE_LOCKED();
+
+    for (size_t i = 0; i < LWIP_ARRAYSIZE(sConnections); i++)
+    {
+        if (!sConnections[i].mInUse)
+        {
+            connection = &sConnections[i];
+            break;
+        }
+    }
+
+    if (connection == NULL)
+    {
+        return ERR_MEM;
+    }
+
+    memset(connection, 0, sizeof(*connection));
+    connection->mInUse        = true;
+    connection->mHasAllocator = (aAllocator != NULL);
+    connection->mPort         = aPort;
+    connection->mCallback     = aCallback;
+    connection->mContext      = aContext;
+
+    if (aAllocator != NULL)
+    {
+        connection->mAllocator = *aAllocator;
+    }
+
+    err = dnsResolveAll(aHostName, addresses, &numAddresses, handleResolved, connection);
+
+    if (err == ERR_OK)
+    {
+        setAddresses(connection, addresses, numAddresses);
+        err = (numAddresses > 0) ? startNextAttempt(connection) : ERR_VAL;
+    }
+    else if (err == ERR_INPROGRESS)
+    {
+        err = ERR_OK;
+    }
+
+    if (err != ERR_OK)
+    {
+        connection->mInUse = false;
+    }
+
+    return err;
+}
@@ -28,7 +28,23 @@
 
 #include "net/utils/nat64_utils.h"
 
-#include "lwip/netdb.h"
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <openthread/openthread-freertos.h>
+
+#include "lwip/tcpip.h"
+
+#include "net/utils/dns_resolver.h"
+
+#define DNS_NOTIFY_VALUE (1 << 12)
+
+struct DnsContext
+{
+    TaskHandle_t mTaskHandle;
+    ip6_addr_t * mAddress;
+    int          mResult;
+};
 
 static ip6_addr_t sNat64Prefix;
 
@@ -45,17 +61,42 @@ ip6_addr_t getNat64Address(const ip4_addr_t *aIpv4Address)
     return addr;
 }
 
+static void dnsHandle(const char *aHostName, const ip6_addr_t *aAddress, void *aContext)
+{
+    struct DnsContext *ctx = (struct DnsContext *)aContext;
+
+    (void)aHostName;
+
+    if (aAddress != NULL)
+    {
+        *ctx->mAddress = *aAddress;
+        ctx->mResult   = 0;
+    }
+
+    xTaskNotify(ctx->mTaskHandle, DNS_NOTIFY_VALUE, eSetBits);
+}
+
 int dnsNat64Address(const char *aHostName, ip6_addr_t *aAddrOut)
 {
-    ip4_addr_t      v4Addr;
-    struct hostent *host = gethostbyname(aHostName);
-    int             ret  = -1;
-    if (host && host->h_addr_list && host->h_addrtype == AF_INET)
+    struct DnsContext ctx;
+    err_t             err;
+
+    ctx.mTaskHandle = xTaskGetCurrentTaskHandle();
+    ctx.mAddress    = aAddrOut;
+    ctx.mResult     = -1;
+
+    LOCK_TCPIP_CORE();
+    err = dnsResolve(aHostName, aAddrOut, dnsHandle, &ctx);
+    UNLOCK_TCPIP_CORE();
+
+    if (err == ERR_OK)
+    {
+        ctx.mResult = 0;
+    }
+    else if (err == ERR_INPROGRESS)
     {
-        memcpy(&v4Addr.addr, host->h_addr_list[0], sizeof(v4Addr.addr));
-        *aAddrOut = getNat64Address(&v4Addr);
-        ret       = 0;
+        otrTaskNotifyWaitBits(DNS_NOTIFY_VALUE);
     }
 
-    return ret;
+    return ctx.mResult;
 }
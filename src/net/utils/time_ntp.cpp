@@ -64,7 +64,6 @@ uint64_t timeNtp()
     otSntpQuery   query;
     otMessageInfo messageInfo;
     NtpContext    ctx;
-    uint32_t      notifyValue = 0;
     ip6_addr_t    serverAddr;
     if (dnsNat64Address("time.google.com", &serverAddr) == 0)
     {
@@ -78,10 +77,7 @@ uint64_t timeNtp()
         ctx.mTaskHandle = xTaskGetCurrentTaskHandle();
         OT_API_CALL(otSntpClientQuery(instance, &query, ntpHandle, &ctx));
 
-        while ((notifyValue & NTP_NOTIFY_VALUE) == 0)
-        {
-            xTaskNotifyWait(0, NTP_NOTIFY_VALUE, &notifyValue, portMAX_DELAY);
-        }
+        otrTaskNotifyWaitBits(NTP_NOTIFY_VALUE);
 
         if (ctx.mErr != OT_ERROR_NONE)
         {
@@ -106,6 +106,18 @@ extern "C" {
 #define configUSE_COUNTING_SEMAPHORES 1
 #define configUSE_QUEUE_SETS 1
 #define configUSE_TASK_NOTIFICATIONS 1
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 2 /* lwIP per-thread semaphore, mbedTLS arena */
+#ifndef configSUPPORT_STATIC_ALLOCATION
+#define configSUPPORT_STATIC_ALLOCATION 0 /* Set by the OTR_STATIC_ALLOCATION CMake option */
+#endif
+
+#if OTR_CONFIG_VIRTUAL_TIME_ENABLE
+/* Step the simulated clock to the next deadline whenever all tasks are blocked, see virtual_time.h. The argument
+is the TickType_t of the Linux port. */
+extern void virtualTimeSuppressTicksAndSleep(unsigned long xExpectedIdleTime);
+#define configUSE_TICKLESS_IDLE 1
+#define portSUPPRESS_TICKS_AND_SLEEP(xExpectedIdleTime) virtualTimeSuppressTicksAndSleep(xExpectedIdleTime)
+#endif
 
 /* Software timer related configuration options. */
 #define configUSE_TIMERS 1
@@ -30,9 +30,12 @@
 #include <stdio.h>
 #include <unistd.h>
 
+#include "utils/heap.h"
+
 void vApplicationMallocFailedHook(void)
 {
     printf("failed malloc\n");
+    otrHeapDump();
     assert(0);
 }
 
@@ -76,6 +76,10 @@
 #define configUSE_TIME_SLICING                                                    0
 #define configUSE_NEWLIB_REENTRANT                                                0
 #define configENABLE_BACKWARD_COMPATIBILITY                                       1
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS                                   2    /* lwIP per-thread semaphore, mbedTLS arena */
+#ifndef configSUPPORT_STATIC_ALLOCATION
+#define configSUPPORT_STATIC_ALLOCATION                                           0    /* Set by the OTR_STATIC_ALLOCATION CMake option */
+#endif
 
 /* Hook function related definitions. */
 #define configUSE_IDLE_HOOK                                                       0
@@ -24,6 +24,7 @@
 #include "config.h"
 #include "jwt-private.h"
 #include "utils/entropy_utils.h"
+#include "utils/heap.h"
 
 #define SHA256_OUT_SIZE (32)
 #define SHA384_OUT_SIZE (48)
@@ -56,7 +57,7 @@ int jwt_sign_sha_hmac(jwt_t *jwt, char **out, unsigned int *len, const char *str
         return EINVAL;
     }
 
-    *out = malloc(out_size);
+    *out = otrHeapAppMalloc(out_size);
     if (*out == NULL)
         return ENOMEM;
 
@@ -84,7 +85,7 @@ int jwt_verify_sha_hmac(jwt_t *jwt, const char *head, const char *sig)
         if (!strcmp(sig, buf))
             ret = 0;
 
-        free(sig_check);
+        otrHeapAppFree(sig_check);
     }
 
     return ret;
@@ -123,7 +124,7 @@ static int decode_der_to_rs(const unsigned char *sig, unsigned char **rs, unsign
 
     *len = adj << 1;
 
-    *rs = malloc(*len);
+    *rs = otrHeapAppMalloc(*len);
     if (*rs == NULL)
     {
         return ENOMEM;
@@ -269,7 +270,12 @@ int jwt_sign_sha_pem(jwt_t *jwt, char **out, unsigned int *len, const char *str)
 
     if (pk_type == MBEDTLS_PK_RSA)
     {
-        *out = malloc(out_size);
+        *out = otrHeapAppMalloc(out_size);
+        if (*out == NULL)
+        {
+            ret = ENOMEM;
+            goto exit;
+        }
         memcpy(*out, out_buf, out_size);
         *len = out_size;
         ret  = 0;
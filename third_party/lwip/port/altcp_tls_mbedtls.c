@@ -66,6 +66,7 @@
 #include "lwip/priv/altcp_priv.h"
 
 #include "altcp_tls_mbedtls_mem.h"
+#include "altcp_tls_mbedtls_port.h"
 #include "altcp_tls_mbedtls_structs.h"
 
 /* @todo: which includes are really needed? */
@@ -78,6 +79,7 @@
 #include "mbedtls/memory_buffer_alloc.h"
 #include "mbedtls/net.h"
 #include "mbedtls/platform.h"
+#include "mbedtls/platform_util.h"
 #include "mbedtls/ssl.h"
 #include "mbedtls/ssl_cache.h"
 #include "mbedtls/x509.h"
@@ -86,7 +88,10 @@
 
 #include <string.h>
 
+#include "arch/altcp_tls_session.h"
+#include "arch/pbuf_class.h"
 #include "utils/entropy_utils.h"
+#include "utils/mbedtls_alloc.h"
 
 #ifndef ALTCP_MBEDTLS_ENTROPY_PTR
 #define ALTCP_MBEDTLS_ENTROPY_PTR NULL
@@ -112,13 +117,25 @@ struct altcp_tls_config
     /** Inter-connection cache for fast connection startup */
     struct mbedtls_ssl_cache_context cache;
 #endif
+    /** Client session offered by, and saved from, every connection (see altcp_tls_config_resume) */
+    struct altcp_tls_session *session;
 };
 
+/** A client session, allocated outside of any connection arena as it outlives its connection */
+struct altcp_tls_session
+{
+    mbedtls_ssl_session data;
+};
+
+static struct altcp_tls_session_stats altcp_mbedtls_session_stats;
+
 static err_t altcp_mbedtls_lower_recv(void *arg, struct altcp_pcb *inner_conn, struct pbuf *p, err_t err);
 static err_t altcp_mbedtls_setup(void *conf, struct altcp_pcb *conn, struct altcp_pcb *inner_conn);
 static err_t altcp_mbedtls_lower_recv_process(struct altcp_pcb *conn, altcp_mbedtls_state_t *state);
 static err_t altcp_mbedtls_handle_rx_appldata(struct altcp_pcb *conn, altcp_mbedtls_state_t *state);
 static int   altcp_mbedtls_bio_send(void *ctx, const unsigned char *dataptr, size_t size);
+static void  altcp_mbedtls_session_done(altcp_mbedtls_state_t *state);
+static void  altcp_mbedtls_session_failed(altcp_mbedtls_state_t *state);
 
 /* callback functions from inner/lower connection: */
 
@@ -273,7 +290,9 @@ static err_t altcp_mbedtls_lower_recv_process(struct altcp_pcb *conn, altcp_mbed
     if (!(state->flags & ALTCP_MBEDTLS_FLAGS_HANDSHAKE_DONE))
     {
         /* handle connection setup (handshake not done) */
-        int ret = mbedtls_ssl_handshake(&state->ssl_context);
+        otrMbedtlsArena *prev = otrMbedtlsArenaEnter(altcp_mbedtls_arena(state));
+        int              ret  = mbedtls_ssl_handshake(&state->ssl_context);
+        otrMbedtlsArenaExit(prev);
         /* try to send data... */
         altcp_output(conn->inner_conn);
         if (state->bio_bytes_read)
@@ -292,6 +311,7 @@ static err_t altcp_mbedtls_lower_recv_process(struct altcp_pcb *conn, altcp_mbed
         if (ret != 0)
         {
             LWIP_DEBUGF(ALTCP_MBEDTLS_DEBUG, ("mbedtls_ssl_handshake failed: %d\n", ret));
+            altcp_mbedtls_session_failed(state);
             /* handshake failed, connection has to be closed */
             if (conn->err)
             {
@@ -308,6 +328,8 @@ static err_t altcp_mbedtls_lower_recv_process(struct altcp_pcb *conn, altcp_mbed
         LWIP_ASSERT("state", state->bio_bytes_read == 0);
         LWIP_ASSERT("state", state->bio_bytes_appl == 0);
         state->flags |= ALTCP_MBEDTLS_FLAGS_HANDSHAKE_DONE;
+        otrMbedtlsArenaHandshakeDone(altcp_mbedtls_arena(state));
+        altcp_mbedtls_session_done(state);
         /* issue "connect" callback" to upper connection (this can only happen for active open) */
         if (conn->connected)
         {
@@ -382,7 +404,8 @@ static err_t altcp_mbedtls_pass_rx_data(struct altcp_pcb *conn, altcp_mbedtls_st
 /* Helper function that processes rx application data stored in rx pbuf chain */
 static err_t altcp_mbedtls_handle_rx_appldata(struct altcp_pcb *conn, altcp_mbedtls_state_t *state)
 {
-    int ret;
+    int              ret;
+    otrMbedtlsArena *prev;
     LWIP_ASSERT("state != NULL", state != NULL);
     if (!(state->flags & ALTCP_MBEDTLS_FLAGS_HANDSHAKE_DONE))
     {
@@ -391,8 +414,15 @@ static err_t altcp_mbedtls_handle_rx_appldata(struct altcp_pcb *conn, altcp_mbed
     }
     do
     {
-        /* allocate a full-sized unchained PBUF_POOL: this is for RX! */
-        struct pbuf *buf = pbuf_alloc(PBUF_RAW, PBUF_POOL_BUFSIZE, PBUF_POOL);
+        /* allocate an unchained RX buffer for the rest of the current record, or of the largest size class when a
+           new record starts and its length is still unknown; a full PBUF_POOL buffer when the classes are exhausted */
+        size_t       avail = mbedtls_ssl_get_bytes_avail(&state->ssl_context);
+        u16_t        size  = (avail == 0 || avail > pbuf_class_max_size()) ? pbuf_class_max_size() : (u16_t)avail;
+        struct pbuf *buf   = pbuf_class_alloc(size);
+        if (buf == NULL)
+        {
+            buf = pbuf_alloc(PBUF_RAW, PBUF_POOL_BUFSIZE, PBUF_POOL);
+        }
         if (buf == NULL)
         {
             /* We're short on pbufs, try again later from 'poll' or 'recv' callbacks.
@@ -401,7 +431,9 @@ static err_t altcp_mbedtls_handle_rx_appldata(struct altcp_pcb *conn, altcp_mbed
         }
 
         /* decrypt application data, this pulls encrypted RX data off state->rx pbuf chain */
-        ret = mbedtls_ssl_read(&state->ssl_context, (unsigned char *)buf->payload, PBUF_POOL_BUFSIZE);
+        prev = otrMbedtlsArenaEnter(altcp_mbedtls_arena(state));
+        ret  = mbedtls_ssl_read(&state->ssl_context, (unsigned char *)buf->payload, buf->len);
+        otrMbedtlsArenaExit(prev);
         if (ret < 0)
         {
             if (ret == MBEDTLS_ERR_SSL_CLIENT_RECONNECT)
@@ -438,9 +470,9 @@ static err_t altcp_mbedtls_handle_rx_appldata(struct altcp_pcb *conn, altcp_mbed
             err_t err;
             if (ret)
             {
-                LWIP_ASSERT("bogus receive length", (unsigned)ret <= PBUF_POOL_BUFSIZE);
-                /* trim pool pbuf to actually decoded length */
-                pbuf_realloc(buf, (u16_t)ret);
+                LWIP_ASSERT("bogus receive length", (unsigned)ret <= buf->len);
+                /* trim to actually decoded length, moving to a smaller size class as it may wait in rx_app */
+                buf = pbuf_class_trim(buf, (u16_t)ret);
 
                 state->bio_bytes_appl += ret;
                 if (mbedtls_ssl_get_bytes_avail(&state->ssl_context) == 0)
@@ -637,11 +669,109 @@ static void altcp_mbedtls_setup_callbacks(struct altcp_pcb *conn, struct altcp_p
     /* listen is set totally different :-) */
 }
 
+/* Copy the session of a connection. The copy is made outside of the connection arena as it outlives the
+   connection, and without the peer certificate, which a resumed handshake does not need. */
+static int altcp_mbedtls_copy_session(altcp_mbedtls_state_t *state, mbedtls_ssl_session *dest)
+{
+    otrMbedtlsArena *prev = otrMbedtlsArenaEnter(NULL);
+    int              ret;
+
+    mbedtls_ssl_session_free(dest);
+    ret = mbedtls_ssl_get_session(&state->ssl_context, dest);
+    if (ret != 0)
+    {
+        mbedtls_ssl_session_free(dest);
+    }
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    else if (dest->peer_cert != NULL)
+    {
+        mbedtls_x509_crt_free(dest->peer_cert);
+        mbedtls_free(dest->peer_cert);
+        dest->peer_cert = NULL;
+    }
+#endif
+    otrMbedtlsArenaExit(prev);
+    return ret;
+}
+
+/* Offer a session on a client connection whose handshake did not start yet */
+static err_t altcp_mbedtls_offer_session(altcp_mbedtls_state_t *state, const mbedtls_ssl_session *session)
+{
+    altcp_mbedtls_resume_t *resume = altcp_mbedtls_resume(state);
+    otrMbedtlsArena *       prev;
+    int                     ret;
+    size_t                  ticket_len = 0;
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    ticket_len = session->ticket_len;
+#endif
+    if ((session->id_len == 0 && ticket_len == 0) || state->ssl_context.state != MBEDTLS_SSL_HELLO_REQUEST)
+    {
+        return ERR_VAL;
+    }
+    /* the copy mbedTLS makes belongs to the connection */
+    prev = otrMbedtlsArenaEnter(altcp_mbedtls_arena(state));
+    ret  = mbedtls_ssl_set_session(&state->ssl_context, session);
+    otrMbedtlsArenaExit(prev);
+    if (ret != 0)
+    {
+        LWIP_DEBUGF(ALTCP_MBEDTLS_DEBUG, ("mbedtls_ssl_set_session failed: %d\n", ret));
+        return (ret == MBEDTLS_ERR_SSL_ALLOC_FAILED) ? ERR_MEM : ERR_VAL;
+    }
+    resume->offered = 1;
+    MEMCPY(resume->master, session->master, ALTCP_MBEDTLS_RESUME_MASTER_LEN);
+    return ERR_OK;
+}
+
+/* Count a completed client handshake and save its session into the config */
+static void altcp_mbedtls_session_done(altcp_mbedtls_state_t *state)
+{
+    struct altcp_tls_config *conf   = (struct altcp_tls_config *)state->conf;
+    altcp_mbedtls_resume_t * resume = altcp_mbedtls_resume(state);
+
+    if (conf->conf.endpoint != MBEDTLS_SSL_IS_CLIENT)
+    {
+        return;
+    }
+    /* a resumed handshake keeps the master secret, a full one derives a new one */
+    if (resume->offered &&
+        memcmp(resume->master, state->ssl_context.session->master, ALTCP_MBEDTLS_RESUME_MASTER_LEN) == 0)
+    {
+        altcp_mbedtls_session_stats.resumed++;
+    }
+    else
+    {
+        altcp_mbedtls_session_stats.full++;
+        if (resume->offered)
+        {
+            altcp_mbedtls_session_stats.rejected++;
+        }
+    }
+    /* the copy of the master secret is only needed for the comparison above */
+    mbedtls_platform_zeroize(resume->master, ALTCP_MBEDTLS_RESUME_MASTER_LEN);
+    if (conf->session != NULL && altcp_mbedtls_copy_session(state, &conf->session->data) != 0)
+    {
+        LWIP_DEBUGF(ALTCP_MBEDTLS_DEBUG, ("altcp_tls: saving the session failed\n"));
+    }
+}
+
+/* Forget the session of the config after a handshake offering it failed, so the next one starts afresh */
+static void altcp_mbedtls_session_failed(altcp_mbedtls_state_t *state)
+{
+    struct altcp_tls_config *conf = (struct altcp_tls_config *)state->conf;
+
+    if (altcp_mbedtls_resume(state)->offered && conf->session != NULL)
+    {
+        mbedtls_ssl_session_free(&conf->session->data);
+    }
+}
+
 static err_t altcp_mbedtls_setup(void *conf, struct altcp_pcb *conn, struct altcp_pcb *inner_conn)
 {
     int                      ret;
     struct altcp_tls_config *config = (struct altcp_tls_config *)conf;
     altcp_mbedtls_state_t *  state;
+    otrMbedtlsArena *        prev;
     if (!conf)
     {
         return ERR_ARG;
@@ -656,7 +786,9 @@ static err_t altcp_mbedtls_setup(void *conf, struct altcp_pcb *conn, struct altc
     }
     /* initialize mbedtls context: */
     mbedtls_ssl_init(&state->ssl_context);
-    ret = mbedtls_ssl_setup(&state->ssl_context, &config->conf);
+    prev = otrMbedtlsArenaEnter(altcp_mbedtls_arena(state));
+    ret  = mbedtls_ssl_setup(&state->ssl_context, &config->conf);
+    otrMbedtlsArenaExit(prev);
     if (ret != 0)
     {
         LWIP_DEBUGF(ALTCP_MBEDTLS_DEBUG, ("mbedtls_ssl_setup failed\n"));
@@ -666,6 +798,11 @@ static err_t altcp_mbedtls_setup(void *conf, struct altcp_pcb *conn, struct altc
     }
     /* tell mbedtls about our I/O functions */
     mbedtls_ssl_set_bio(&state->ssl_context, conn, altcp_mbedtls_bio_send, altcp_mbedtls_bio_recv, NULL);
+    if (config->session != NULL)
+    {
+        /* an empty session or a failing copy just means a full handshake */
+        altcp_mbedtls_offer_session(state, &config->session->data);
+    }
 
     altcp_mbedtls_setup_callbacks(conn, inner_conn);
     conn->inner_conn = inner_conn;
@@ -703,6 +840,73 @@ void *altcp_tls_context(struct altcp_pcb *conn)
     return NULL;
 }
 
+struct altcp_tls_session *altcp_tls_init_session(void)
+{
+    struct altcp_tls_session *session = (struct altcp_tls_session *)mem_calloc(1, sizeof(struct altcp_tls_session));
+    if (session != NULL)
+    {
+        mbedtls_ssl_session_init(&session->data);
+    }
+    return session;
+}
+
+void altcp_tls_free_session(struct altcp_tls_session *session)
+{
+    if (session != NULL)
+    {
+        mbedtls_ssl_session_free(&session->data);
+        mem_free(session);
+    }
+}
+
+err_t altcp_tls_get_session(struct altcp_pcb *conn, struct altcp_tls_session *dest)
+{
+    altcp_mbedtls_state_t *state;
+    int                    ret;
+
+    if (conn == NULL || conn->fns != &altcp_mbedtls_functions || conn->state == NULL || dest == NULL)
+    {
+        return ERR_VAL;
+    }
+    state = (altcp_mbedtls_state_t *)conn->state;
+    if (!(state->flags & ALTCP_MBEDTLS_FLAGS_HANDSHAKE_DONE) ||
+        ((struct altcp_tls_config *)state->conf)->conf.endpoint != MBEDTLS_SSL_IS_CLIENT)
+    {
+        return ERR_VAL;
+    }
+    ret = altcp_mbedtls_copy_session(state, &dest->data);
+    if (ret != 0)
+    {
+        return (ret == MBEDTLS_ERR_SSL_ALLOC_FAILED) ? ERR_MEM : ERR_VAL;
+    }
+    return ERR_OK;
+}
+
+err_t altcp_tls_set_session(struct altcp_pcb *conn, struct altcp_tls_session *from)
+{
+    if (conn == NULL || conn->fns != &altcp_mbedtls_functions || conn->state == NULL || from == NULL)
+    {
+        return ERR_VAL;
+    }
+    return altcp_mbedtls_offer_session((altcp_mbedtls_state_t *)conn->state, &from->data);
+}
+
+void altcp_tls_config_resume(struct altcp_tls_config *conf, struct altcp_tls_session *session)
+{
+    LWIP_ASSERT("conf != NULL", conf != NULL);
+    conf->session = session;
+}
+
+void altcp_tls_get_session_stats(struct altcp_tls_session_stats *stats)
+{
+    *stats = altcp_mbedtls_session_stats;
+}
+
+void altcp_tls_reset_session_stats(void)
+{
+    memset(&altcp_mbedtls_session_stats, 0, sizeof(altcp_mbedtls_session_stats));
+}
+
 #if ALTCP_MBEDTLS_DEBUG != LWIP_DBG_OFF
 static void altcp_mbedtls_debug(void *ctx, int level, const char *file, int line, const char *str)
 {
@@ -1145,6 +1349,7 @@ static err_t altcp_mbedtls_write(struct altcp_pcb *conn, const void *dataptr, u1
 {
     int                    ret;
     altcp_mbedtls_state_t *state;
+    otrMbedtlsArena *      prev;
 
     LWIP_UNUSED_ARG(apiflags);
 
@@ -1176,7 +1381,9 @@ static err_t altcp_mbedtls_write(struct altcp_pcb *conn, const void *dataptr, u1
             return ERR_MEM;
         }
     }
-    ret = mbedtls_ssl_write(&state->ssl_context, (const unsigned char *)dataptr, len);
+    prev = otrMbedtlsArenaEnter(altcp_mbedtls_arena(state));
+    ret  = mbedtls_ssl_write(&state->ssl_context, (const unsigned char *)dataptr, len);
+    otrMbedtlsArenaExit(prev);
     /* try to send data... */
     altcp_output(conn->inner_conn);
     if (ret >= 0)
@@ -1267,7 +1474,9 @@ static void altcp_mbedtls_dealloc(struct altcp_pcb *conn)
         altcp_mbedtls_state_t *state = (altcp_mbedtls_state_t *)conn->state;
         if (state)
         {
+            otrMbedtlsArena *prev = otrMbedtlsArenaEnter(altcp_mbedtls_arena(state));
             mbedtls_ssl_free(&state->ssl_context);
+            otrMbedtlsArenaExit(prev);
             state->flags = 0;
             if (state->rx)
             {
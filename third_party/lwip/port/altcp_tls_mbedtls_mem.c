@@ -0,0 +1,115 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *   This file replaces the lwIP altcp TLS memory functions, giving every connection an mbedTLS arena.
+ */
+
+#include "lwip/opt.h"
+
+#if LWIP_ALTCP && LWIP_ALTCP_TLS && LWIP_ALTCP_TLS_MBEDTLS
+
+#include "lwip/apps/altcp_tls_mbedtls_opts.h"
+#include "lwip/mem.h"
+
+#include "mbedtls/platform_util.h"
+
+#include "altcp_tls_mbedtls_mem.h"
+#include "altcp_tls_mbedtls_port.h"
+
+typedef struct altcp_mbedtls_port_state_s
+{
+    altcp_mbedtls_state_t  state; // must be first, lwIP only sees this part
+    otrMbedtlsArena        arena;
+    altcp_mbedtls_resume_t resume;
+} altcp_mbedtls_port_state_t;
+
+void altcp_mbedtls_mem_init(void)
+{
+    // The allocator is handed to mbedTLS by otrInit().
+}
+
+altcp_mbedtls_state_t *altcp_mbedtls_alloc(void *conf)
+{
+    altcp_mbedtls_port_state_t *ret = (altcp_mbedtls_port_state_t *)mem_calloc(1, sizeof(altcp_mbedtls_port_state_t));
+
+    if (ret == NULL)
+    {
+        return NULL;
+    }
+
+    ret->state.conf = conf;
+    otrMbedtlsArenaInit(&ret->arena);
+
+    return &ret->state;
+}
+
+void altcp_mbedtls_free(void *conf, altcp_mbedtls_state_t *state)
+{
+    altcp_mbedtls_port_state_t *portState = (altcp_mbedtls_port_state_t *)state;
+
+    LWIP_UNUSED_ARG(conf);
+    LWIP_ASSERT("state != NULL", state != NULL);
+
+    otrMbedtlsArenaRelease(&portState->arena);
+    // A connection closed before its handshake completed still holds the offered master secret.
+    mbedtls_platform_zeroize(&portState->resume, sizeof(portState->resume));
+    mem_free(portState);
+}
+
+otrMbedtlsArena *altcp_mbedtls_arena(altcp_mbedtls_state_t *state)
+{
+    return &((altcp_mbedtls_port_state_t *)state)->arena;
+}
+
+altcp_mbedtls_resume_t *altcp_mbedtls_resume(altcp_mbedtls_state_t *state)
+{
+    return &((altcp_mbedtls_port_state_t *)state)->resume;
+}
+
+void *altcp_mbedtls_alloc_config(size_t size)
+{
+    void * ret          = NULL;
+    size_t checked_size = (mem_size_t)size;
+
+    if (size == checked_size)
+    {
+        ret = mem_calloc(1, (mem_size_t)size);
+    }
+
+    return ret;
+}
+
+void altcp_mbedtls_free_config(void *item)
+{
+    LWIP_ASSERT("item != NULL", item != NULL);
+    mem_free(item);
+}
+
+#endif // LWIP_ALTCP && LWIP_ALTCP_TLS && LWIP_ALTCP_TLS_MBEDTLS
@@ -0,0 +1,58 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *   This file declares the connection state this port keeps next to the lwIP altcp TLS state.
+ */
+
+#ifndef ALTCP_TLS_MBEDTLS_PORT_H_
+#define ALTCP_TLS_MBEDTLS_PORT_H_
+
+#include "altcp_tls_mbedtls_structs.h"
+
+#include "utils/mbedtls_alloc.h"
+
+/** Size of the master secret prefix remembered for a session offered to the server */
+#define ALTCP_MBEDTLS_RESUME_MASTER_LEN 8
+
+/** Session resumption bookkeeping of a client connection */
+typedef struct altcp_mbedtls_resume_s
+{
+    u8_t offered; /* a session was handed to mbedTLS before the handshake */
+    u8_t master[ALTCP_MBEDTLS_RESUME_MASTER_LEN]; /* a resumed handshake keeps the master secret of the offer */
+} altcp_mbedtls_resume_t;
+
+/* The mbedTLS arena of a connection. mbedTLS calls on a connection are made inside its arena so that all its
+   allocations are charged to, and released with, it. */
+otrMbedtlsArena *altcp_mbedtls_arena(altcp_mbedtls_state_t *state);
+
+/* The session resumption bookkeeping of a connection, cleared when the connection is allocated. */
+altcp_mbedtls_resume_t *altcp_mbedtls_resume(altcp_mbedtls_state_t *state);
+
+#endif // ALTCP_TLS_MBEDTLS_PORT_H_
@@ -0,0 +1,142 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *   This file declares TLS client session resumption on the altcp TLS layer.
+ *
+ *   A session saved from a connection lets the next connection to the same server skip the certificate exchange and
+ *   key agreement, by session ID or session ticket, whichever the server supports. All functions must be called with
+ *   the tcpip core lock held, like the rest of the altcp API.
+ *
+ *   Sessions are kept in memory only. A session holds the master secret, anyone who obtains it can decrypt the
+ *   connections resuming it. Persisting sessions across reboots needs mbedtls_ssl_session_save(), available from
+ *   mbedTLS 2.19 on, and a store protecting that key material.
+ */
+
+#ifndef LWIP_PORT_ALTCP_TLS_SESSION_H_
+#define LWIP_PORT_ALTCP_TLS_SESSION_H_
+
+#include "lwip/altcp.h"
+#include "lwip/altcp_tls.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct altcp_tls_session;
+
+/**
+ * The handshakes of client connections.
+ */
+struct altcp_tls_session_stats
+{
+    u32_t full;     // handshakes which did not resume a session
+    u32_t resumed;  // handshakes which resumed a session
+    u32_t rejected; // full handshakes although a session was offered, also counted in full
+};
+
+/**
+ * This function allocates an empty session.
+ *
+ * @returns The session, NULL if out of memory.
+ *
+ */
+struct altcp_tls_session *altcp_tls_init_session(void);
+
+/**
+ * This function frees a session.
+ *
+ * @param[in]  session  The session, may be NULL.
+ *
+ */
+void altcp_tls_free_session(struct altcp_tls_session *session);
+
+/**
+ * This function saves the session of a client connection whose handshake is done.
+ *
+ * The peer certificate is not kept, resumed connections have no peer certificate to inspect.
+ *
+ * @param[in]   conn  The connection.
+ * @param[out]  dest  The session, its previous content is freed.
+ *
+ * @retval ERR_OK   The session was saved.
+ * @retval ERR_VAL  The connection is not a client TLS connection or its handshake is not done.
+ * @retval ERR_MEM  Out of memory.
+ *
+ */
+err_t altcp_tls_get_session(struct altcp_pcb *conn, struct altcp_tls_session *dest);
+
+/**
+ * This function offers a session to the server on a client connection, before its handshake starts.
+ *
+ * Servers which do not know the session any more answer with a full handshake.
+ *
+ * @param[in]  conn  The connection, as returned by altcp_tls_wrap() or altcp_tls_new().
+ * @param[in]  from  The session, it is copied.
+ *
+ * @retval ERR_OK   The session will be offered.
+ * @retval ERR_VAL  The session is empty, or the handshake already started.
+ * @retval ERR_MEM  Out of memory.
+ *
+ */
+err_t altcp_tls_set_session(struct altcp_pcb *conn, struct altcp_tls_session *from);
+
+/**
+ * This function makes a client configuration resume sessions on its own.
+ *
+ * Every connection created with the configuration offers @p session, and every successful handshake saves its
+ * session back into it, so the session survives the teardown of the connections. A handshake failing after the offer
+ * empties the session.
+ *
+ * @param[in]  conf     The client configuration.
+ * @param[in]  session  The session, owned by the caller and kept until the configuration is freed or this function
+ *                      is called again, NULL to stop resuming.
+ *
+ */
+void altcp_tls_config_resume(struct altcp_tls_config *conf, struct altcp_tls_session *session);
+
+/**
+ * This function copies the handshake counters of client connections.
+ *
+ * @param[out]  stats  The counters.
+ *
+ */
+void altcp_tls_get_session_stats(struct altcp_tls_session_stats *stats);
+
+/**
+ * This function resets the handshake counters of client connections.
+ *
+ */
+void altcp_tls_reset_session_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LWIP_PORT_ALTCP_TLS_SESSION_H_
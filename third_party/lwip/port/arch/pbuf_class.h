@@ -0,0 +1,121 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *   This file declares the size classes of the receive pbufs.
+ *
+ *   Each class is a memp pool of unchained custom pbufs holding at most its payload size, see PBUF_CLASS_POOLS in
+ *   lwipopts.h. Requests are served best fit and move on to the next larger class when the fitting one is exhausted.
+ */
+
+#ifndef LWIP_PORT_PBUF_CLASS_H_
+#define LWIP_PORT_PBUF_CLASS_H_
+
+#include "lwip/pbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PBUF_CLASS_COUNT(aName, aSize, aNum) +1
+
+/**
+ * The number of size classes.
+ */
+#define PBUF_CLASS_NUM (0 PBUF_CLASS_POOLS(PBUF_CLASS_COUNT))
+
+/**
+ * The occupancy of a size class.
+ */
+struct pbuf_class_stats
+{
+    const char *name;
+    u16_t       size;      // payload size of the buffers
+    u16_t       num;       // number of buffers
+    u16_t       used;      // buffers currently allocated
+    u16_t       peak;      // high-water mark of used
+    u32_t       allocs;    // buffers handed out
+    u32_t       exhausted; // requests which fitted but found the class empty
+};
+
+/**
+ * This function initializes the size class pools, it is called by sys_init().
+ *
+ */
+void pbuf_class_init(void);
+
+/**
+ * This function allocates an unchained PBUF_RAW pbuf from the smallest class that fits and has a free buffer.
+ *
+ * @param[in]  length  The payload length, the returned pbuf has len and tot_len set to it.
+ *
+ * @returns The pbuf, NULL if @p length exceeds the largest class or every fitting class is exhausted.
+ *
+ */
+struct pbuf *pbuf_class_alloc(u16_t length);
+
+/**
+ * This function trims a pbuf to a shorter length, like pbuf_realloc().
+ *
+ * A pbuf of a size class moves to a smaller class when one fits @p length and has a free buffer. This is meant for
+ * buffers sized before their content was known, which may then wait long in a receive queue.
+ *
+ * @param[in]  p       The pbuf, ownership passes to the function.
+ * @param[in]  length  The new length, not larger than p->tot_len.
+ *
+ * @returns The trimmed pbuf, either @p p or its replacement.
+ *
+ */
+struct pbuf *pbuf_class_trim(struct pbuf *p, u16_t length);
+
+/**
+ * This function returns the payload size of the largest class.
+ *
+ */
+u16_t pbuf_class_max_size(void);
+
+/**
+ * This function copies the occupancy of every class.
+ *
+ * @param[out]  stats  Array of PBUF_CLASS_NUM entries, in class order.
+ *
+ */
+void pbuf_class_get_stats(struct pbuf_class_stats *stats);
+
+/**
+ * This function resets the peaks and counters of every class to the current occupancy.
+ *
+ */
+void pbuf_class_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LWIP_PORT_PBUF_CLASS_H_
@@ -42,11 +42,24 @@ typedef xSemaphoreHandle sys_sem_t;
 typedef xSemaphoreHandle sys_mutex_t;
 typedef xTaskHandle      sys_thread_t;
 
+#if configSUPPORT_STATIC_ALLOCATION
+/**
+ * The capacity of every mailbox when they are statically allocated, see sys_arch.c for the pool sizes.
+ */
+#ifndef SYS_ARCH_STATIC_MBOX_SIZE
+#define SYS_ARCH_STATIC_MBOX_SIZE TCPIP_MBOX_SIZE
+#endif
+#endif
+
 typedef struct sys_mbox_s
 {
     xQueueHandle os_mbox;
-    sys_mutex_t  lock;
+    uint8_t      waiters; // tasks blocked in sys_arch_mbox_fetch(), woken by sys_mbox_free()
     uint8_t      alive;
+#if configSUPPORT_STATIC_ALLOCATION
+    StaticQueue_t os_mbox_buffer;
+    void *        os_mbox_storage[SYS_ARCH_STATIC_MBOX_SIZE];
+#endif
 } * sys_mbox_t;
 
 #define LWIP_COMPAT_MUTEX 0
@@ -64,6 +77,27 @@ typedef struct sys_mbox_s
 
 typedef uint32_t sys_prot_t;
 
+void *sys_arch_mem_malloc(size_t size);
+void *sys_arch_mem_calloc(size_t count, size_t size);
+void  sys_arch_mem_free(void *mem);
+
+#if LWIP_NETCONN_SEM_PER_THREAD
+/**
+ * The task notification bit signalled on the per-thread semaphore, the low bit of such a sys_sem_t is set and the
+ * rest is the task handle. The thread local storage pointer at LWIP_NETCONN_THREAD_SEM_TLS_INDEX holds it.
+ */
+#define LWIP_SEM_NOTIFY_VALUE (1 << 14)
+#define LWIP_NETCONN_THREAD_SEM_TLS_INDEX 0
+
+sys_sem_t *sys_arch_netconn_sem_get(void);
+void       sys_arch_netconn_sem_alloc(void);
+void       sys_arch_netconn_sem_free(void);
+
+#define LWIP_NETCONN_THREAD_SEM_GET() sys_arch_netconn_sem_get()
+#define LWIP_NETCONN_THREAD_SEM_ALLOC() sys_arch_netconn_sem_alloc()
+#define LWIP_NETCONN_THREAD_SEM_FREE() sys_arch_netconn_sem_free()
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -63,6 +63,15 @@
    ------------------------------------
 */
 #define MEM_LIBC_MALLOC 1
+
+/**
+ * mem_clib_malloc, mem_clib_calloc, mem_clib_free: the heap functions used with MEM_LIBC_MALLOC, they charge
+ * lwIP in the heap statistics.
+ */
+#define mem_clib_malloc sys_arch_mem_malloc
+#define mem_clib_calloc sys_arch_mem_calloc
+#define mem_clib_free sys_arch_mem_free
+
 /**
  * MEM_ALIGNMENT: should be set to the alignment of the CPU
  *    4 byte alignment -> #define MEM_ALIGNMENT 4
@@ -166,9 +175,11 @@
 #define MEMP_NUM_TCPIP_MSG_INPKT 8
 
 /**
- * PBUF_POOL_SIZE: the number of buffers in the pbuf pool.
+ * PBUF_POOL_SIZE: the number of buffers in the pbuf pool. Received packets and
+ * decrypted TLS records come from PBUF_CLASS_POOLS, this pool only backs them
+ * up when a packet is too large or every fitting class is exhausted.
  */
-#define PBUF_POOL_SIZE 64
+#define PBUF_POOL_SIZE 16
 
 /*
    ---------------------------------
@@ -355,6 +366,22 @@
  */
 #define PBUF_POOL_BUFSIZE LWIP_MEM_ALIGN_SIZE(TCP_MSS + 40 + PBUF_LINK_HLEN)
 
+/**
+ * PBUF_CLASS_POOLS: the size classes of the receive buffers as
+ * X(name, payload size, number of buffers) entries, in ascending size, see
+ * arch/pbuf_class.h. The last class holds a full IPv6 MTU, so a packet from
+ * the Thread interface always fits in one buffer.
+ */
+#define PBUF_CLASS_POOLS(X) \
+    X(SMALL, 128, 24)       \
+    X(MEDIUM, 512, 16)      \
+    X(MTU, 1280, 8)
+
+/**
+ * LWIP_SUPPORT_CUSTOM_PBUF==1: the size classes hand out custom pbufs.
+ */
+#define LWIP_SUPPORT_CUSTOM_PBUF 1
+
 /*
    ------------------------------------
    ---------- LOOPIF options ----------
@@ -386,6 +413,12 @@
  */
 #define LWIP_SOCKET 1
 
+/**
+ * LWIP_NETCONN_SEM_PER_THREAD==1: Blocking netconn and socket calls wait on a semaphore of the calling thread
+ * instead of one per netconn. The port backs it with a task notification bit.
+ */
+#define LWIP_NETCONN_SEM_PER_THREAD 1
+
 /*
    ------------------------------------
    ---------- IPv6 options ----------
@@ -0,0 +1,194 @@
+/*
+ *  Copyright (c) 2020, The OpenThread Authors.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *  3. Neither the name of the copyright holder nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ *  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ *  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ *  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ *  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ *  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ *  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ *  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ *  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ *   This file implements the size classes of the receive pbufs.
+ */
+
+#include "arch/pbuf_class.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "lwip/memp.h"
+#include "lwip/sys.h"
+
+struct pbuf_class_buf
+{
+    struct pbuf_custom pc; // must be first, pbuf_free() hands it back as the pbuf
+    u8_t               cls;
+};
+
+#define PBUF_CLASS_PAYLOAD_OFFSET LWIP_MEM_ALIGN_SIZE(sizeof(struct pbuf_class_buf))
+
+#define PBUF_CLASS_DECLARE(aName, aSize, aNum)                                                             \
+    LWIP_MEMPOOL_DECLARE(PBUF_CLASS_##aName, aNum, PBUF_CLASS_PAYLOAD_OFFSET + LWIP_MEM_ALIGN_SIZE(aSize), \
+                         "PBUF_" #aName)
+#define PBUF_CLASS_POOL(aName, aSize, aNum) &memp_PBUF_CLASS_##aName,
+#define PBUF_CLASS_CONFIG(aName, aSize, aNum) {.name = #aName, .size = aSize, .num = aNum},
+
+PBUF_CLASS_POOLS(PBUF_CLASS_DECLARE)
+
+static const struct memp_desc *const sPools[PBUF_CLASS_NUM] = {PBUF_CLASS_POOLS(PBUF_CLASS_POOL)};
+
+static struct pbuf_class_stats sStats[PBUF_CLASS_NUM] = {PBUF_CLASS_POOLS(PBUF_CLASS_CONFIG)};
+
+static void pbufClassFree(struct pbuf *p)
+{
+    struct pbuf_class_buf *buf = (struct pbuf_class_buf *)p;
+    u8_t                   cls = buf->cls;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    memp_free_pool(sPools[cls], buf);
+
+    SYS_ARCH_PROTECT(lev);
+    sStats[cls].used--;
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+void pbuf_class_init(void)
+{
+    for (u8_t i = 0; i < PBUF_CLASS_NUM; i++)
+    {
+        memp_init_pool(sPools[i]);
+    }
+}
+
+static bool isClassPbuf(const struct pbuf *p)
+{
+    return (p->flags & PBUF_FLAG_IS_CUSTOM) != 0 &&
+           ((const struct pbuf_custom *)p)->custom_free_function == pbufClassFree;
+}
+
+static struct pbuf *allocBelow(u16_t length, u8_t limit)
+{
+    struct pbuf_class_buf *buf = NULL;
+    u8_t                   i;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    for (i = 0; i < limit; i++)
+    {
+        if (sStats[i].size < length)
+        {
+            continue;
+        }
+
+        buf = (struct pbuf_class_buf *)memp_malloc_pool(sPools[i]);
+
+        SYS_ARCH_PROTECT(lev);
+        if (buf == NULL)
+        {
+            sStats[i].exhausted++;
+        }
+        else
+        {
+            sStats[i].allocs++;
+            if (++sStats[i].used > sStats[i].peak)
+            {
+                sStats[i].peak = sStats[i].used;
+            }
+        }
+        SYS_ARCH_UNPROTECT(lev);
+
+        if (buf != NULL)
+        {
+            break;
+        }
+    }
+
+    if (buf == NULL)
+    {
+        return NULL;
+    }
+
+    buf->cls                     = i;
+    buf->pc.custom_free_function = pbufClassFree;
+
+    // PBUF_REF, as the payload does not start right after struct pbuf lwIP must not grow headers in front of it.
+    return pbuf_alloced_custom(PBUF_RAW, length, PBUF_REF, &buf->pc, (u8_t *)buf + PBUF_CLASS_PAYLOAD_OFFSET,
+                               sStats[i].size);
+}
+
+struct pbuf *pbuf_class_alloc(u16_t length)
+{
+    return allocBelow(length, PBUF_CLASS_NUM);
+}
+
+struct pbuf *pbuf_class_trim(struct pbuf *p, u16_t length)
+{
+    struct pbuf *fit;
+
+    LWIP_ASSERT("pbuf_class_trim: cannot grow", length <= p->tot_len);
+    pbuf_realloc(p, length);
+
+    if (p->next != NULL || !isClassPbuf(p))
+    {
+        return p;
+    }
+
+    fit = allocBelow(length, ((struct pbuf_class_buf *)p)->cls);
+
+    if (fit == NULL)
+    {
+        return p;
+    }
+
+    MEMCPY(fit->payload, p->payload, length);
+    pbuf_free(p);
+
+    return fit;
+}
+
+u16_t pbuf_class_max_size(void)
+{
+    return sStats[PBUF_CLASS_NUM - 1].size;
+}
+
+void pbuf_class_get_stats(struct pbuf_class_stats *stats)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    MEMCPY(stats, sStats, sizeof(sStats));
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+void pbuf_class_reset_stats(void)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    for (u8_t i = 0; i < PBUF_CLASS_NUM; i++)
+    {
+        sStats[i].peak      = sStats[i].used;
+        sStats[i].allocs    = 0;
+        sStats[i].exhausted = 0;
+    }
+    SYS_ARCH_UNPROTECT(lev);
+}
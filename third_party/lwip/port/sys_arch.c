@@ -34,6 +34,7 @@
 #include <assert.h>
 
 #include <arch/cc.h>
+#include <arch/pbuf_class.h>
 #include <arch/sys_arch.h>
 
 #include <lwip/debug.h>
@@ -44,14 +45,107 @@
 
 #include <stdbool.h>
 
-static sys_mutex_t g_lwip_protect_mutex = NULL;
+#include "portable/portable.h"
+#include "utils/heap.h"
+
+// Returned by sys_arch_protect() outside interrupts, where the critical section nests on its own.
+#define SYS_ARCH_PROTECT_TASK ((sys_prot_t)-1)
+
+void *sys_arch_mem_malloc(size_t size)
+{
+    return otrHeapMalloc(OTR_HEAP_TAG_LWIP, size);
+}
+
+void *sys_arch_mem_calloc(size_t count, size_t size)
+{
+    return otrHeapCalloc(OTR_HEAP_TAG_LWIP, count, size);
+}
+
+void sys_arch_mem_free(void *mem)
+{
+    otrHeapFree(mem);
+}
+
+#if configSUPPORT_STATIC_ALLOCATION
+/*
+ * With static allocation every kernel object comes from the fixed pools below, sized for the tcpip thread and
+ * MEMP_NUM_NETCONN connections. Running out is reported as ERR_MEM, as a failing heap would be.
+ */
+#ifndef SYS_ARCH_STATIC_MUTEXES
+#define SYS_ARCH_STATIC_MUTEXES 4
+#endif
+
+#ifndef SYS_ARCH_STATIC_SEMS
+#define SYS_ARCH_STATIC_SEMS 4
+#endif
+
+// The tcpip mailbox, and the receive and accept mailboxes of every netconn.
+#ifndef SYS_ARCH_STATIC_MBOXES
+#define SYS_ARCH_STATIC_MBOXES (1 + 2 * MEMP_NUM_NETCONN)
+#endif
+
+#ifndef SYS_ARCH_STATIC_THREADS
+#define SYS_ARCH_STATIC_THREADS 1
+#endif
+
+#ifndef SYS_ARCH_STATIC_THREAD_STACKSIZE
+#define SYS_ARCH_STATIC_THREAD_STACKSIZE TCPIP_THREAD_STACKSIZE
+#endif
+
+#if !LWIP_COMPAT_MUTEX
+static StaticSemaphore_t sMutexBuffers[SYS_ARCH_STATIC_MUTEXES];
+static bool              sMutexUsed[SYS_ARCH_STATIC_MUTEXES];
+#endif
+static StaticSemaphore_t sSemBuffers[SYS_ARCH_STATIC_SEMS];
+static bool              sSemUsed[SYS_ARCH_STATIC_SEMS];
+static struct sys_mbox_s sMboxes[SYS_ARCH_STATIC_MBOXES];
+static bool              sMboxUsed[SYS_ARCH_STATIC_MBOXES];
+static StaticTask_t      sThreadBuffers[SYS_ARCH_STATIC_THREADS];
+static StackType_t       sThreadStacks[SYS_ARCH_STATIC_THREADS][SYS_ARCH_STATIC_THREAD_STACKSIZE];
+static bool              sThreadUsed[SYS_ARCH_STATIC_THREADS];
+
+static int claimSlot(bool *used, int count)
+{
+    int index = -1;
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    for (int i = 0; i < count; i++)
+    {
+        if (!used[i])
+        {
+            used[i] = true;
+            index   = i;
+            break;
+        }
+    }
+    SYS_ARCH_UNPROTECT(lev);
+
+    return index;
+}
+
+static void releaseSlot(bool *used, int index)
+{
+    SYS_ARCH_DECL_PROTECT(lev);
+
+    SYS_ARCH_PROTECT(lev);
+    used[index] = false;
+    SYS_ARCH_UNPROTECT(lev);
+}
+#endif // configSUPPORT_STATIC_ALLOCATION
 
 #if !LWIP_COMPAT_MUTEX
 err_t sys_mutex_new(sys_mutex_t *mutex)
 {
     err_t err = ERR_MEM;
 
+#if configSUPPORT_STATIC_ALLOCATION
+    int slot = claimSlot(sMutexUsed, SYS_ARCH_STATIC_MUTEXES);
+
+    *mutex = (slot < 0) ? NULL : xSemaphoreCreateMutexStatic(&sMutexBuffers[slot]);
+#else
     *mutex = xSemaphoreCreateMutex();
+#endif
 
     if (*mutex != NULL)
     {
@@ -83,19 +177,112 @@ void sys_mutex_unlock(sys_mutex_t *mutex)
 void sys_mutex_free(sys_mutex_t *mutex)
 {
     vQueueDelete(*mutex);
+#if configSUPPORT_STATIC_ALLOCATION
+    releaseSlot(sMutexUsed, (StaticSemaphore_t *)*mutex - sMutexBuffers);
+#endif
 }
 #endif
 
+#if LWIP_NETCONN_SEM_PER_THREAD
+#define SYS_SEM_TASK_TAG ((uintptr_t)1)
+
+static bool isTaskSem(sys_sem_t sem)
+{
+    return ((uintptr_t)sem & SYS_SEM_TASK_TAG) != 0;
+}
+
+static u32_t waitTaskSem(u32_t timeout)
+{
+    TickType_t start    = xTaskGetTickCount();
+    TickType_t ticks    = timeout / portTICK_PERIOD_MS;
+    uint32_t   others   = 0;
+    bool       signaled = false;
+    bool       timedOut = false;
+    uint32_t   value;
+
+    do
+    {
+        TickType_t elapsed   = xTaskGetTickCount() - start;
+        TickType_t remaining = (timeout == 0) ? portMAX_DELAY : ((elapsed < ticks) ? ticks - elapsed : 0);
+
+        if (xTaskNotifyWait(0, LWIP_SEM_NOTIFY_VALUE, &value, remaining) == pdTRUE)
+        {
+            signaled = (value & LWIP_SEM_NOTIFY_VALUE) != 0;
+            others |= value & ~LWIP_SEM_NOTIFY_VALUE;
+        }
+        else
+        {
+            timedOut = (timeout != 0);
+        }
+    } while (!signaled && !timedOut);
+
+    // Bits of other users woke this wait and consumed the pending state, re-arm it for their own wait.
+    if (others != 0)
+    {
+        xTaskNotify(xTaskGetCurrentTaskHandle(), others, eSetBits);
+    }
+
+    return signaled ? (xTaskGetTickCount() - start) * portTICK_PERIOD_MS : SYS_ARCH_TIMEOUT;
+}
+
+sys_sem_t *sys_arch_netconn_sem_get(void)
+{
+    sys_sem_t *sem = pvTaskGetThreadLocalStoragePointer(NULL, LWIP_NETCONN_THREAD_SEM_TLS_INDEX);
+
+    if (sem == NULL)
+    {
+        sys_arch_netconn_sem_alloc();
+        sem = pvTaskGetThreadLocalStoragePointer(NULL, LWIP_NETCONN_THREAD_SEM_TLS_INDEX);
+    }
+
+    return sem;
+}
+
+void sys_arch_netconn_sem_alloc(void)
+{
+    sys_sem_t *sem;
+
+    if (pvTaskGetThreadLocalStoragePointer(NULL, LWIP_NETCONN_THREAD_SEM_TLS_INDEX) == NULL)
+    {
+        // Once per thread, the semaphore itself is the task notification and needs no kernel object.
+        sem = mem_malloc(sizeof(sys_sem_t));
+        LWIP_ASSERT("sys_arch_netconn_sem_alloc: out of memory", sem != NULL);
+
+        *sem = (sys_sem_t)((uintptr_t)xTaskGetCurrentTaskHandle() | SYS_SEM_TASK_TAG);
+        vTaskSetThreadLocalStoragePointer(NULL, LWIP_NETCONN_THREAD_SEM_TLS_INDEX, sem);
+    }
+}
+
+void sys_arch_netconn_sem_free(void)
+{
+    sys_sem_t *sem = pvTaskGetThreadLocalStoragePointer(NULL, LWIP_NETCONN_THREAD_SEM_TLS_INDEX);
+
+    if (sem != NULL)
+    {
+        vTaskSetThreadLocalStoragePointer(NULL, LWIP_NETCONN_THREAD_SEM_TLS_INDEX, NULL);
+        mem_free(sem);
+    }
+}
+#endif // LWIP_NETCONN_SEM_PER_THREAD
+
 err_t sys_sem_new(sys_sem_t *sem, u8_t count)
 {
     err_t err = ERR_MEM;
-    *sem      = xSemaphoreCreateBinary();
+
+#if configSUPPORT_STATIC_ALLOCATION
+    int slot = claimSlot(sSemUsed, SYS_ARCH_STATIC_SEMS);
+
+    *sem = (slot < 0) ? NULL : xSemaphoreCreateBinaryStatic(&sSemBuffers[slot]);
+#else
+    *sem = xSemaphoreCreateBinary();
+#endif
 
     if ((*sem) != NULL)
     {
-        if (count == 0)
+        // Binary semaphores are created empty.
+        if (count != 0)
         {
-            xSemaphoreTake(*sem, 1);
+            xSemaphoreGive(*sem);
         }
 
         err = ERR_OK;
@@ -106,6 +293,14 @@ err_t sys_sem_new(sys_sem_t *sem, u8_t count)
 
 void sys_sem_signal(sys_sem_t *sem)
 {
+#if LWIP_NETCONN_SEM_PER_THREAD
+    if (isTaskSem(*sem))
+    {
+        xTaskNotify((TaskHandle_t)((uintptr_t)*sem & ~SYS_SEM_TASK_TAG), LWIP_SEM_NOTIFY_VALUE, eSetBits);
+        return;
+    }
+#endif
+
     xSemaphoreGive(*sem);
 }
 
@@ -114,6 +309,13 @@ u32_t sys_arch_sem_wait(sys_sem_t *sem, u32_t timeout)
     portTickType  StartTime, EndTime, Elapsed;
     unsigned long ret;
 
+#if LWIP_NETCONN_SEM_PER_THREAD
+    if (isTaskSem(*sem))
+    {
+        return waitTaskSem(timeout);
+    }
+#endif
+
     StartTime = xTaskGetTickCount();
 
     if (timeout != 0)
@@ -146,11 +348,36 @@ u32_t sys_arch_sem_wait(sys_sem_t *sem, u32_t timeout)
 
 void sys_sem_free(sys_sem_t *sem)
 {
+#if LWIP_NETCONN_SEM_PER_THREAD
+    // Per-thread semaphores are released with LWIP_NETCONN_THREAD_SEM_FREE().
+    if (isTaskSem(*sem))
+    {
+        return;
+    }
+#endif
+
     vSemaphoreDelete(*sem);
+#if configSUPPORT_STATIC_ALLOCATION
+    releaseSlot(sSemUsed, (StaticSemaphore_t *)*sem - sSemBuffers);
+#endif
 }
 
 err_t sys_mbox_new(sys_mbox_t *mbox, int size)
 {
+#if configSUPPORT_STATIC_ALLOCATION
+    int slot;
+
+    LWIP_ASSERT("sys_mbox_new: size exceeds SYS_ARCH_STATIC_MBOX_SIZE", size <= SYS_ARCH_STATIC_MBOX_SIZE);
+
+    if (size > SYS_ARCH_STATIC_MBOX_SIZE || (slot = claimSlot(sMboxUsed, SYS_ARCH_STATIC_MBOXES)) < 0)
+    {
+        return ERR_MEM;
+    }
+
+    *mbox            = &sMboxes[slot];
+    (*mbox)->os_mbox = xQueueCreateStatic(size, sizeof(void *), (uint8_t *)(*mbox)->os_mbox_storage,
+                                          &(*mbox)->os_mbox_buffer);
+#else
     *mbox = mem_malloc(sizeof(struct sys_mbox_s));
     if (*mbox == NULL)
     {
@@ -164,15 +391,10 @@ err_t sys_mbox_new(sys_mbox_t *mbox, int size)
         mem_free(*mbox);
         return ERR_MEM;
     }
+#endif
 
-    if (sys_mutex_new(&((*mbox)->lock)) != ERR_OK)
-    {
-        vQueueDelete((*mbox)->os_mbox);
-        mem_free(*mbox);
-        return ERR_MEM;
-    }
-
-    (*mbox)->alive = true;
+    (*mbox)->waiters = 0;
+    (*mbox)->alive   = true;
 
     return ERR_OK;
 }
@@ -223,11 +445,12 @@ err_t sys_mbox_trypost_fromisr(sys_mbox_t *mbox, void *msg)
 
 u32_t sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout)
 {
-    void *        dummyptr;
-    portTickType  StartTime, EndTime, Elapsed;
-    unsigned long ret;
+    void *             dummyptr;
+    struct sys_mbox_s *box;
+    portTickType       StartTime, Elapsed;
+    TickType_t         ticks = (timeout != 0) ? timeout / portTICK_PERIOD_MS : portMAX_DELAY;
+    unsigned long      ret   = SYS_ARCH_TIMEOUT;
 
-    StartTime = xTaskGetTickCount();
     if (msg == NULL)
     {
         msg = &dummyptr;
@@ -239,56 +462,46 @@ u32_t sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout)
         return -1;
     }
 
-    sys_mutex_lock(&(*mbox)->lock);
+    box = *mbox;
 
-    if (timeout != 0)
+    // Fast path for a busy mailbox, such as the tcpip one under load.
+    if (xQueueReceive(box->os_mbox, msg, 0) == pdTRUE)
     {
-        if (pdTRUE == xQueueReceive((*mbox)->os_mbox, &(*msg), timeout / portTICK_PERIOD_MS))
-        {
-            EndTime = xTaskGetTickCount();
-            Elapsed = (EndTime - StartTime) * portTICK_PERIOD_MS;
+        return 0;
+    }
 
-            if (Elapsed == 0)
-            {
-                Elapsed = 1;
-            }
+    StartTime = xTaskGetTickCount();
 
-            ret = Elapsed;
-        }
-        else
-        {
-            *msg = NULL;
-            ret  = SYS_ARCH_TIMEOUT;
-        }
-    }
-    else
+    // Registered before checking alive, sys_mbox_free() either sees this waiter or it is seen dead here.
+    __atomic_add_fetch(&box->waiters, 1, __ATOMIC_SEQ_CST);
+
+    while (__atomic_load_n(&box->alive, __ATOMIC_SEQ_CST))
     {
-        while (1)
+        if (xQueueReceive(box->os_mbox, msg, ticks) == pdTRUE)
         {
-            if (pdTRUE == xQueueReceive((*mbox)->os_mbox, &(*msg), portMAX_DELAY))
-            {
-                break;
-            }
-
-            if ((*mbox)->alive == false)
-            {
-                *msg = NULL;
-                break;
-            }
+            ret = 0;
+            break;
         }
 
-        EndTime = xTaskGetTickCount();
-        Elapsed = (EndTime - StartTime) * portTICK_PERIOD_MS;
-
-        if (Elapsed == 0)
+        if (timeout != 0)
         {
-            Elapsed = 1;
+            break;
         }
+    }
 
-        ret = Elapsed;
+    if (ret == SYS_ARCH_TIMEOUT || !__atomic_load_n(&box->alive, __ATOMIC_SEQ_CST))
+    {
+        *msg = NULL;
+    }
+
+    if (ret != SYS_ARCH_TIMEOUT || timeout == 0)
+    {
+        Elapsed = (xTaskGetTickCount() - StartTime) * portTICK_PERIOD_MS;
+        ret     = (Elapsed == 0) ? 1 : Elapsed;
     }
 
-    sys_mutex_unlock(&(*mbox)->lock);
+    // Last access to the mailbox, sys_mbox_free() may delete it from here on.
+    __atomic_sub_fetch(&box->waiters, 1, __ATOMIC_SEQ_CST);
 
     return ret;
 }
@@ -317,54 +530,44 @@ u32_t sys_arch_mbox_tryfetch(sys_mbox_t *mbox, void **msg)
 
 void sys_mbox_free(sys_mbox_t *mbox)
 {
-#define MAX_POLL_CNT 100
-#define PER_POLL_DELAY 20
-    uint16_t count     = 0;
-    bool     post_null = true;
-
-    (*mbox)->alive = false;
-
-    while (count++ < MAX_POLL_CNT)
-    {
-        if (!sys_mutex_trylock(&(*mbox)->lock))
-        {
-            sys_mutex_unlock(&(*mbox)->lock);
-            break;
-        }
+    struct sys_mbox_s *box  = *mbox;
+    void *             wake = NULL;
 
-        if (post_null)
-        {
-            if (sys_mbox_trypost(mbox, NULL) != ERR_OK)
-            {
-            }
-            else
-            {
-                post_null = false;
-            }
-        }
+    __atomic_store_n(&box->alive, false, __ATOMIC_SEQ_CST);
 
-        if (count == (MAX_POLL_CNT - 1))
-        {
-            printf("WARNING: mbox %p had a consumer who never unblocked. Leaking!\n", (*mbox)->os_mbox);
-        }
-        vTaskDelay(PER_POLL_DELAY / portTICK_PERIOD_MS);
-    }
-
-    if (uxQueueMessagesWaiting((*mbox)->os_mbox))
+    // Wake and drain, every blocked consumer gets a NULL message, sees the mailbox dead and leaves.
+    while (__atomic_load_n(&box->waiters, __ATOMIC_SEQ_CST) != 0)
     {
-        xQueueReset((*mbox)->os_mbox);
-        /* Line for breakpoint.  Should never break here! */
-        __asm__ volatile("nop");
+        xQueueSendToBack(box->os_mbox, &wake, 0);
+        vTaskDelay(1);
     }
 
-    vQueueDelete((*mbox)->os_mbox);
-    sys_mutex_free(&(*mbox)->lock);
-    mem_free(*mbox);
+    vQueueDelete(box->os_mbox);
+#if configSUPPORT_STATIC_ALLOCATION
+    releaseSlot(sMboxUsed, box - sMboxes);
+#else
+    mem_free(box);
+#endif
     *mbox = NULL;
 }
 
 sys_thread_t sys_thread_new(const char *name, lwip_thread_fn thread, void *arg, int stacksize, int prio)
 {
+#if configSUPPORT_STATIC_ALLOCATION
+    int slot;
+
+    LWIP_ASSERT("sys_thread_new: stacksize exceeds SYS_ARCH_STATIC_THREAD_STACKSIZE",
+                stacksize <= SYS_ARCH_STATIC_THREAD_STACKSIZE);
+
+    // lwIP threads never exit, their slots are not given back.
+    if (stacksize > SYS_ARCH_STATIC_THREAD_STACKSIZE || (slot = claimSlot(sThreadUsed, SYS_ARCH_STATIC_THREADS)) < 0)
+    {
+        return NULL;
+    }
+
+    return xTaskCreateStatic(thread, name, SYS_ARCH_STATIC_THREAD_STACKSIZE, arg, prio, sThreadStacks[slot],
+                             &sThreadBuffers[slot]);
+#else
     xTaskHandle   CreatedTask;
     portBASE_TYPE result;
 
@@ -378,26 +581,47 @@ sys_thread_t sys_thread_new(const char *name, lwip_thread_fn thread, void *arg,
     {
         return NULL;
     }
+#endif
 }
 
 void sys_init(void)
 {
-    if (ERR_OK != sys_mutex_new(&g_lwip_protect_mutex))
-    {
-        printf("sys_init: failed to init lwip protect mutex\n");
-    }
+    pbuf_class_init();
 }
 
+/*
+ * The protected regions are a few instructions of memp and pbuf bookkeeping, masking interrupts is far cheaper
+ * than a mutex and, unlike one, also works from ISR.
+ */
 sys_prot_t sys_arch_protect(void)
 {
-    sys_mutex_lock(&g_lwip_protect_mutex);
-    return (sys_prot_t)1;
+    uint32_t   inIsr;
+    sys_prot_t pval = SYS_ARCH_PROTECT_TASK;
+
+    OTR_PORT_GET_IN_ISR(inIsr);
+
+    if (inIsr)
+    {
+        pval = (sys_prot_t)taskENTER_CRITICAL_FROM_ISR();
+    }
+    else
+    {
+        taskENTER_CRITICAL();
+    }
+
+    return pval;
 }
 
 void sys_arch_unprotect(sys_prot_t pval)
 {
-    (void)pval;
-    sys_mutex_unlock(&g_lwip_protect_mutex);
+    if (pval == SYS_ARCH_PROTECT_TASK)
+    {
+        taskEXIT_CRITICAL();
+    }
+    else
+    {
+        taskEXIT_CRITICAL_FROM_ISR((UBaseType_t)pval);
+    }
 }
 
 u32_t sys_now(void)
@@ -65,6 +65,9 @@
 
 #define MBEDTLS_DEBUG_C
 
+/* Client side session tickets (RFC 5077) for the TLS session resumption of the altcp TLS layer */
+#define MBEDTLS_SSL_SESSION_TICKETS
+
 #include "mbedtls/check_config.h"
 
 #endif /* MBEDTLS_CONFIG_H */